@@ -0,0 +1,234 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "krclib.h"
+
+// Throughput and latency of the lock-free queues.
+// Usage: bench_queue [items]
+
+SPSC_QUEUE_TEMPLATE(uint64_t, u64_spsc)
+MPMC_QUEUE_TEMPLATE(uint64_t, u64_mpmc)
+
+#define QUEUE_CAPACITY  1024
+#define BATCH_SIZE      64
+#define MAX_THREADS     8
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+// Give the other side a chance when the queue is full or empty; spinning
+// without yielding never finishes on machines with fewer cores than threads.
+static void backoff(void)
+{
+	sched_yield();
+}
+
+struct bench
+{
+	struct u64_spsc  spsc, reply;
+	struct u64_mpmc  mpmc;
+	uint64_t         items;         // per producer
+	int              batch;         // 1 uses the try API
+	int              producers;
+	atomic_uint_fast64_t sum;
+};
+
+
+//----------------------------------------------------------------------
+// SPSC
+
+static void *spsc_producer(void *arg)
+{
+	struct bench *b = arg;
+	uint64_t batch[BATCH_SIZE];
+
+	for (uint64_t i = 0; i < b->items; ) {
+		if (b->batch == 1) {
+			if (u64_spsc_try_push(&b->spsc, i))
+				++i;
+			else
+				backoff();
+			continue;
+		}
+		int n = 0;
+		for (; n < b->batch && i + n < b->items; ++n)
+			batch[n] = i + n;
+		for (Size sent = 0; sent < n; ) {
+			Size pushed = u64_spsc_push_n(&b->spsc, batch + sent, n - sent);
+			if (pushed == 0)
+				backoff();
+			sent += pushed;
+		}
+		i += n;
+	}
+	return NULL;
+}
+
+static void *spsc_consumer(void *arg)
+{
+	struct bench *b = arg;
+	uint64_t batch[BATCH_SIZE], sum = 0;
+
+	for (uint64_t got = 0; got < b->items; ) {
+		Size n = u64_spsc_pop_n(&b->spsc, batch, b->batch);
+		if (n == 0)
+			backoff();
+		for (Size k = 0; k < n; ++k)
+			sum += batch[k];
+		got += n;
+	}
+	atomic_store(&b->sum, sum);
+	return NULL;
+}
+
+static void bench_spsc_throughput(uint64_t items, int batch)
+{
+	struct bench b = { .items = items, .batch = batch };
+	u64_spsc_init(&b.spsc, QUEUE_CAPACITY);
+
+	pthread_t producer, consumer;
+	uint64_t start = now_ns();
+	pthread_create(&consumer, NULL, spsc_consumer, &b);
+	pthread_create(&producer, NULL, spsc_producer, &b);
+	pthread_join(producer, NULL);
+	pthread_join(consumer, NULL);
+	double seconds = (now_ns() - start) / 1e9;
+
+	bool ok = atomic_load(&b.sum) == items * (items - 1) / 2;
+	printf("spsc  1x1  batch %2d  %8.1f M items/s  %s\n", batch, items / seconds / 1e6, ok ? "" : "WRONG SUM");
+	u64_spsc_dispose(&b.spsc);
+}
+
+static void *spsc_echo(void *arg)
+{
+	struct bench *b = arg;
+	uint64_t value;
+
+	for (uint64_t i = 0; i < b->items; ++i) {
+		while (!u64_spsc_try_pop(&b->spsc, &value))
+			backoff();
+		while (!u64_spsc_try_push(&b->reply, value))
+			backoff();
+	}
+	return NULL;
+}
+
+// Round trips through a pair of queues; one way is half of that.
+static void bench_spsc_latency(uint64_t trips)
+{
+	struct bench b = { .items = trips };
+	u64_spsc_init(&b.spsc, QUEUE_CAPACITY);
+	u64_spsc_init(&b.reply, QUEUE_CAPACITY);
+
+	pthread_t echo;
+	pthread_create(&echo, NULL, spsc_echo, &b);
+
+	uint64_t value, start = now_ns();
+	for (uint64_t i = 0; i < trips; ++i) {
+		while (!u64_spsc_try_push(&b.spsc, i))
+			backoff();
+		while (!u64_spsc_try_pop(&b.reply, &value))
+			backoff();
+	}
+	double ns = (double)(now_ns() - start) / trips;
+	pthread_join(echo, NULL);
+
+	printf("spsc  latency         %8.1f ns one way\n", ns / 2);
+	u64_spsc_dispose(&b.spsc);
+	u64_spsc_dispose(&b.reply);
+}
+
+
+//----------------------------------------------------------------------
+// MPMC
+
+static void *mpmc_producer(void *arg)
+{
+	struct bench *b = arg;
+	uint64_t batch[BATCH_SIZE];
+
+	for (uint64_t i = 0; i < b->items; ) {
+		int n = 0;
+		for (; n < b->batch && i + n < b->items; ++n)
+			batch[n] = i + n;
+		for (Size sent = 0; sent < n; ) {
+			Size pushed = u64_mpmc_push_n(&b->mpmc, batch + sent, n - sent);
+			if (pushed == 0)
+				backoff();
+			sent += pushed;
+		}
+		i += n;
+	}
+	return NULL;
+}
+
+static atomic_uint_fast64_t mpmc_received;
+
+static void *mpmc_consumer(void *arg)
+{
+	struct bench *b = arg;
+	uint64_t batch[BATCH_SIZE], sum = 0, total = b->items * b->producers;
+
+	while (atomic_load_explicit(&mpmc_received, memory_order_relaxed) < total) {
+		Size n = u64_mpmc_pop_n(&b->mpmc, batch, b->batch);
+		if (n == 0)
+			backoff();
+		for (Size k = 0; k < n; ++k)
+			sum += batch[k];
+		atomic_fetch_add_explicit(&mpmc_received, n, memory_order_relaxed);
+	}
+	atomic_fetch_add(&b->sum, sum);
+	return NULL;
+}
+
+static void bench_mpmc_throughput(uint64_t items, int threads, int batch)
+{
+	struct bench b = { .items = items / threads, .batch = batch, .producers = threads };
+	u64_mpmc_init(&b.mpmc, QUEUE_CAPACITY);
+	atomic_store(&mpmc_received, 0);
+	atomic_store(&b.sum, 0);
+
+	pthread_t producers[MAX_THREADS], consumers[MAX_THREADS];
+	uint64_t start = now_ns();
+	for (int t = 0; t < threads; ++t) {
+		pthread_create(&consumers[t], NULL, mpmc_consumer, &b);
+		pthread_create(&producers[t], NULL, mpmc_producer, &b);
+	}
+	for (int t = 0; t < threads; ++t) {
+		pthread_join(producers[t], NULL);
+		pthread_join(consumers[t], NULL);
+	}
+	double seconds = (now_ns() - start) / 1e9;
+
+	uint64_t per = b.items;
+	bool ok = atomic_load(&b.sum) == threads * (per * (per - 1) / 2);
+	printf("mpmc  %dx%d  batch %2d  %8.1f M items/s  %s\n", threads, threads, batch,
+			per * threads / seconds / 1e6, ok ? "" : "WRONG SUM");
+	u64_mpmc_dispose(&b.mpmc);
+}
+
+
+int main(int argc, char *argv[])
+{
+	uint64_t items = (argc > 1) ? strtoull(argv[1], NULL, 10) : 10000000;
+	setvbuf(stdout, NULL, _IONBF, 0);
+
+	bench_spsc_throughput(items, 1);
+	bench_spsc_throughput(items, BATCH_SIZE);
+	bench_spsc_latency(items / 10);
+
+	for (int threads = 1; threads <= 4; threads *= 2) {
+		bench_mpmc_throughput(items, threads, 1);
+		bench_mpmc_throughput(items, threads, BATCH_SIZE);
+	}
+
+	return 0;
+}
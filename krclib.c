@@ -5,25 +5,13 @@
 #include <setjmp.h>
 #include <ctype.h>
 #include <limits.h>
+#include <math.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/uio.h>
 
 #include "krclib.h"
 
-//----------------------------------------------------------------------
-// Primitive Utilities
-
-static char *kr_int_to_str_back(int n, char *ps)
-{
-	int sign = n < 0 ? -1 : 1;
-
-	*ps-- = '\0';
-	do *ps-- = sign * (n % 10) + '0';
-	while ((n /= 10) != 0);
-
-	if (sign < 0)  *ps-- = '-';
-
-	return ++ps;
-}
-
 //----------------------------------------------------------------------
 // Error Module
 
@@ -161,6 +149,16 @@ size_t try_size_add(size_t a, size_t b, struct except_frame *xf, SourceLine loc)
 	return a + b;
 }
 
+bool uint64_mult_overflows(uint64_t a, uint64_t b)
+{
+	return b != 0 && a > UINT64_MAX / b;
+}
+
+bool uint64_add_overflows(uint64_t a, uint64_t b)
+{
+	return a > UINT64_MAX - b;
+}
+
 bool int_mult_overflows(int a, int b)
 {
 	if (a > 0  &&  b > 0)
@@ -220,239 +218,4187 @@ char *strbuf_end(strbuf buf)
 	return buf.front + buf.size - 1;
 }
 
-
-bool strand_equals(struct strand a, struct strand b)
+enum status strbuf_cat(struct strbuf *buf, struct strand str)
 {
-	if (strand_length(a) != strand_length(b))
-		return false;
+	int len = strand_length(str);
+	if (len > strbuf_cap(buf))
+		return STATUS_OUT_OF_SPACE;
 
-	return !strncmp(a.front, b.front, strand_length(a));
+	memcpy(buf->back, str.front, len);
+	buf->back += len;
+
+	return STATUS_OK;
 }
 
-void strand_fputs(FILE *out, struct strand str)
+struct strand strbuf_strand(struct strbuf buf)
 {
-	fprintf(out, "%.*s\n", strand_length(str), str.front);
+	return (struct strand){ .front = buf.front, .back = buf.back };
 }
 
-struct strand strand_trim_back(struct strand s, int (*istype)(int))
+enum status strbuf_vprintf(struct strbuf *buf, const char *format, va_list args)
 {
-	while (s.back > s.front && istype(*(s.back-1))) 
-		--s.back;
-	return s;
+	int cap = strbuf_cap(buf);
+	int length = vsnprintf(buf->back, cap, format, args);
+
+	if (length < 0)
+		return STATUS_ERROR;
+
+	if (length >= cap) {
+		if (cap > 0)  buf->back += cap - 1;
+		return STATUS_OUT_OF_SPACE;
+	}
+
+	buf->back += length;
+	return STATUS_OK;
 }
 
-struct strand strand_trim_front(struct strand s, int (*istype)(int))
+enum status strbuf_printf(struct strbuf *buf, const char *format, ...)
 {
-	while (s.front < s.back && istype(*s.front)) 
-		++s.front;
-	return s;
+	va_list args;
+	va_start(args, format);
+	enum status stat = strbuf_vprintf(buf, format, args);
+	va_end(args);
+	return stat;
 }
 
-struct strand strand_trim(struct strand s, int (*istype)(int))
+static Size strand_join_length(const struct strand parts[], int count, struct strand sep)
 {
-	return strand_trim_back( strand_trim_front(s, istype), istype);
+	Size total = (count > 0) ? (Size)strand_length(sep) * (count - 1) : 0;
+	for (int i = 0; i < count; ++i)
+		total += strand_length(parts[i]);
+	return total;
 }
 
-
-
-
-struct byte_span Bytes_init_str(char *s)
+static char *strand_join_copy(char *out, const struct strand parts[], int count, struct strand sep)
 {
-	return (struct byte_span)byte_span_init_n((byte*)s, strlen(s));
+	for (int i = 0; i < count; ++i) {
+		if (i > 0) {
+			memcpy(out, sep.front, strand_length(sep));
+			out += strand_length(sep);
+		}
+		memcpy(out, parts[i].front, strand_length(parts[i]));
+		out += strand_length(parts[i]);
+	}
+	return out;
 }
 
+enum status strbuf_join(struct strbuf *buf, const struct strand parts[], int count, struct strand sep)
+{
+	if (strand_join_length(parts, count, sep) > strbuf_cap(buf))
+		return STATUS_OUT_OF_SPACE;
 
+	buf->back = strand_join_copy(buf->back, parts, count, sep);
+	return STATUS_OK;
+}
 
-#define LIST_MIN_CAPACITY 8
+struct strand strand_join(Arena *a, const struct strand parts[], int count, struct strand sep)
+{
+	Size length = strand_join_length(parts, count, sep);
+	char *front = alloc(a, 1, 1, length + 1, ARENA_NO_FILL, CURRENT_LOCATION).data;
+	char *back  = strand_join_copy(front, parts, count, sep);
+	*back = '\0';
+	return (struct strand){ front, back };
+}
 
-void *List_grow(void *l, int sizeof_base, int sizeof_item, int min_cap, int add_length)
+enum status strbuf_cat_lower(struct strbuf *buf, struct strand str)
 {
-//	CHECK(min_cap || add_length);
+	char *front = buf->back;
+	enum status stat = strbuf_cat(buf, str);
+	if (stat == STATUS_OK)
+		ascii_to_lower(front, strand_length(str));
+	return stat;
+}
 
-	ListDims *b = l;
+//----------------------------------------------------------------------
+// Number formatting Module
 
-	int new_length = List_length(l) + add_length;
-	min_cap = int_max(min_cap, new_length);
+static const char DIGIT_PAIRS[200] =
+	"00010203040506070809" "10111213141516171819"
+	"20212223242526272829" "30313233343536373839"
+	"40414243444546474849" "50515253545556575859"
+	"60616263646566676869" "70717273747576777879"
+	"80818283848586878889" "90919293949596979899";
 
-	if (List_capacity(l) < min_cap) {
-		min_cap = int_max(min_cap, List_capacity(l) * 2);
-		min_cap = int_max(min_cap, LIST_MIN_CAPACITY);
-		b = realloc(l, sizeof_base + sizeof_item * min_cap);
-		b->cap = min_cap;
+static int uint64_digits(uint64_t n)
+{
+	int digits = 1;
+	for (;;) {
+		if (n < 10)     return digits;
+		if (n < 100)    return digits + 1;
+		if (n < 1000)   return digits + 2;
+		if (n < 10000)  return digits + 3;
+		n /= 10000;
+		digits += 4;
 	}
+}
 
-	if (b)  b->length = new_length;
+// Write the len digits of n backwards, two at a time, ending at out+len.
+static void uint64_write_digits(char *out, int len, uint64_t n)
+{
+	char *p = out + len;
+	while (n >= 100) {
+		p -= 2;
+		memcpy(p, &DIGIT_PAIRS[(n % 100) * 2], 2);
+		n /= 100;
+	}
+	if (n >= 10)
+		memcpy(p - 2, &DIGIT_PAIRS[n * 2], 2);
+	else
+		p[-1] = '0' + n;
+}
 
-	return b;
+int uint64_to_str(char *out, uint64_t n)
+{
+	int len = uint64_digits(n);
+	uint64_write_digits(out, len, n);
+	out[len] = '\0';
+	return len;
 }
 
-void List_dispose(void *l)
+int int64_to_str(char *out, int64_t n)
 {
-	free(l);
+	if (n >= 0)
+		return uint64_to_str(out, n);
+
+	*out = '-';
+	return 1 + uint64_to_str(out + 1, -(uint64_t)n);
 }
 
+// 32-bit division is cheaper where the word size is smaller.
+static void uint32_write_digits(char *out, int len, uint32_t n)
+{
+	char *p = out + len;
+	while (n >= 100) {
+		p -= 2;
+		memcpy(p, &DIGIT_PAIRS[(n % 100) * 2], 2);
+		n /= 100;
+	}
+	if (n >= 10)
+		memcpy(p - 2, &DIGIT_PAIRS[n * 2], 2);
+	else
+		p[-1] = '0' + n;
+}
 
+int uint32_to_str(char *out, uint32_t n)
+{
+	int len = uint64_digits(n);
+	uint32_write_digits(out, len, n);
+	out[len] = '\0';
+	return len;
+}
 
-void sum_ints(void *total, void *next_i)
+int int32_to_str(char *out, int32_t n)
 {
-	*(int*)total += *(int*)next_i;
+	if (n >= 0)
+		return uint32_to_str(out, n);
+
+	*out = '-';
+	return 1 + uint32_to_str(out + 1, -(uint32_t)n);
 }
 
+// Grisu2 shortest round-trip double to digits, after Florian Loitsch,
+// "Printing Floating-Point Numbers Quickly and Accurately with Integers"
+// (PLDI 2010). Output always reads back as the same double and is the
+// shortest such string in all but rare cases.
 
+typedef struct { uint64_t f; int e; } diy_fp;
 
-struct link *link_next(struct link *n)
+enum {
+	DOUBLE_SIGNIFICAND_BITS = 52,
+	DOUBLE_EXPONENT_BIAS    = 0x3FF + DOUBLE_SIGNIFICAND_BITS,
+};
+
+#define DOUBLE_HIDDEN_BIT        (1ull << DOUBLE_SIGNIFICAND_BITS)
+#define DOUBLE_SIGNIFICAND_MASK  (DOUBLE_HIDDEN_BIT - 1)
+
+static diy_fp diy_fp_mult(diy_fp a, diy_fp b)
 {
-	return n ? n->next : NULL;
+	const uint64_t M32 = 0xFFFFFFFFu;
+	uint64_t ah = a.f >> 32, al = a.f & M32;
+	uint64_t bh = b.f >> 32, bl = b.f & M32;
+	uint64_t hh = ah * bh, lh = al * bh, hl = ah * bl, ll = al * bl;
+	uint64_t mid = (ll >> 32) + (hl & M32) + (lh & M32) + (1u << 31);
+	return (diy_fp){ hh + (hl >> 32) + (lh >> 32) + (mid >> 32), a.e + b.e + 64 };
 }
 
-struct link *link_prev(struct link *n)
+static diy_fp diy_fp_normalize(diy_fp x)
 {
-	return n ? n->prev : NULL;
+	while (!(x.f & (1ull << 63))) {
+		x.f <<= 1;
+		x.e--;
+	}
+	return x;
 }
 
-_Bool link_is_attached(struct link *n)
+// Cached normalized powers 10^k for k = -348, -340, ..., 340.
+static const uint64_t CACHED_POWERS_F[] = {
+	0xfa8fd5a0081c0288ull, 0xbaaee17fa23ebf76ull, 0x8b16fb203055ac76ull, 0xcf42894a5dce35eaull,
+	0x9a6bb0aa55653b2dull, 0xe61acf033d1a45dfull, 0xab70fe17c79ac6caull, 0xff77b1fcbebcdc4full,
+	0xbe5691ef416bd60cull, 0x8dd01fad907ffc3cull, 0xd3515c2831559a83ull, 0x9d71ac8fada6c9b5ull,
+	0xea9c227723ee8bcbull, 0xaecc49914078536dull, 0x823c12795db6ce57ull, 0xc21094364dfb5637ull,
+	0x9096ea6f3848984full, 0xd77485cb25823ac7ull, 0xa086cfcd97bf97f4ull, 0xef340a98172aace5ull,
+	0xb23867fb2a35b28eull, 0x84c8d4dfd2c63f3bull, 0xc5dd44271ad3cdbaull, 0x936b9fcebb25c996ull,
+	0xdbac6c247d62a584ull, 0xa3ab66580d5fdaf6ull, 0xf3e2f893dec3f126ull, 0xb5b5ada8aaff80b8ull,
+	0x87625f056c7c4a8bull, 0xc9bcff6034c13053ull, 0x964e858c91ba2655ull, 0xdff9772470297ebdull,
+	0xa6dfbd9fb8e5b88full, 0xf8a95fcf88747d94ull, 0xb94470938fa89bcfull, 0x8a08f0f8bf0f156bull,
+	0xcdb02555653131b6ull, 0x993fe2c6d07b7facull, 0xe45c10c42a2b3b06ull, 0xaa242499697392d3ull,
+	0xfd87b5f28300ca0eull, 0xbce5086492111aebull, 0x8cbccc096f5088ccull, 0xd1b71758e219652cull,
+	0x9c40000000000000ull, 0xe8d4a51000000000ull, 0xad78ebc5ac620000ull, 0x813f3978f8940984ull,
+	0xc097ce7bc90715b3ull, 0x8f7e32ce7bea5c70ull, 0xd5d238a4abe98068ull, 0x9f4f2726179a2245ull,
+	0xed63a231d4c4fb27ull, 0xb0de65388cc8ada8ull, 0x83c7088e1aab65dbull, 0xc45d1df942711d9aull,
+	0x924d692ca61be758ull, 0xda01ee641a708deaull, 0xa26da3999aef774aull, 0xf209787bb47d6b85ull,
+	0xb454e4a179dd1877ull, 0x865b86925b9bc5c2ull, 0xc83553c5c8965d3dull, 0x952ab45cfa97a0b3ull,
+	0xde469fbd99a05fe3ull, 0xa59bc234db398c25ull, 0xf6c69a72a3989f5cull, 0xb7dcbf5354e9beceull,
+	0x88fcf317f22241e2ull, 0xcc20ce9bd35c78a5ull, 0x98165af37b2153dfull, 0xe2a0b5dc971f303aull,
+	0xa8d9d1535ce3b396ull, 0xfb9b7cd9a4a7443cull, 0xbb764c4ca7a44410ull, 0x8bab8eefb6409c1aull,
+	0xd01fef10a657842cull, 0x9b10a4e5e9913129ull, 0xe7109bfba19c0c9dull, 0xac2820d9623bf429ull,
+	0x80444b5e7aa7cf85ull, 0xbf21e44003acdd2dull, 0x8e679c2f5e44ff8full, 0xd433179d9c8cb841ull,
+	0x9e19db92b4e31ba9ull, 0xeb96bf6ebadf77d9ull, 0xaf87023b9bf0ee6bull
+};
+
+static const int16_t CACHED_POWERS_E[] = {
+	-1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927,
+	-901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635, -608,
+	-582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316, -289,
+	-263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+	56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+	375, 402, 428, 455, 481, 508, 534, 561, 588, 614, 641, 667,
+	694, 720, 747, 774, 800, 827, 853, 880, 907, 933, 960, 986,
+	1013, 1039, 1066
+};
+
+static diy_fp cached_power(int e, int *k)
 {
-	return n && (n->next || n->prev);
+	double dk = (-61 - e) * 0.30102999566398114 + 347;
+	int ik = (int)dk;
+	if (dk - ik > 0.0)  ++ik;
+
+	int index = (ik >> 3) + 1;
+	*k = -(-348 + index * 8);
+	return (diy_fp){ CACHED_POWERS_F[index], CACHED_POWERS_E[index] };
 }
 
-_Bool link_not_attached(struct link *n)
+static void grisu_round(char *digits, int len, uint64_t delta, uint64_t rest, uint64_t ten_kappa, uint64_t wp_w)
 {
-	return n && !n->next && !n->prev;
+	while (rest < wp_w && delta - rest >= ten_kappa &&
+	       (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w)) {
+		digits[len - 1]--;
+		rest += ten_kappa;
+	}
 }
 
-_Bool links_are_attached(struct link *l, struct link *r)
+static int grisu_digit_gen(diy_fp w, diy_fp mp, uint64_t delta, char *digits, int *k)
 {
-	return l && l->next == r && r && r->prev == l;
+	static const uint32_t POW10[] = {
+		1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+
+	diy_fp one = { 1ull << -mp.e, mp.e };
+	uint64_t wp_w = mp.f - w.f;
+	uint32_t p1 = mp.f >> -one.e;
+	uint64_t p2 = mp.f & (one.f - 1);
+	int kappa = uint64_digits(p1);
+	int len = 0;
+
+	while (kappa > 0) {
+		uint32_t d = p1 / POW10[kappa - 1];
+		p1 %= POW10[kappa - 1];
+		if (d || len)
+			digits[len++] = '0' + d;
+		kappa--;
+
+		uint64_t rest = ((uint64_t)p1 << -one.e) + p2;
+		if (rest <= delta) {
+			*k += kappa;
+			grisu_round(digits, len, delta, rest, (uint64_t)POW10[kappa] << -one.e, wp_w);
+			return len;
+		}
+	}
+
+	for (;;) {
+		p2 *= 10;
+		delta *= 10;
+		char d = p2 >> -one.e;
+		if (d || len)
+			digits[len++] = '0' + d;
+		p2 &= one.f - 1;
+		kappa--;
+
+		if (p2 < delta) {
+			*k += kappa;
+			grisu_round(digits, len, delta, p2, one.f, wp_w * (-kappa < 10 ? POW10[-kappa] : 0));
+			return len;
+		}
+	}
 }
 
-struct link *link_attach(struct link *a, struct link *b)
+// Shortest digits of positive, finite d. Value is digits * 10^k.
+static int grisu2(double d, char *digits, int *k)
 {
-	if (a)  a->next = b;
-	if (b)  b->prev  = a;
-	return b;
+	uint64_t bits;
+	memcpy(&bits, &d, sizeof(bits));
+
+	int biased_e = (bits >> DOUBLE_SIGNIFICAND_BITS) & 0x7FF;
+	diy_fp v = { bits & DOUBLE_SIGNIFICAND_MASK, 1 - DOUBLE_EXPONENT_BIAS };
+	if (biased_e) {
+		v.f += DOUBLE_HIDDEN_BIT;
+		v.e  = biased_e - DOUBLE_EXPONENT_BIAS;
+	}
+
+	// Boundaries halfway to the neighbouring doubles.
+	diy_fp plus = diy_fp_normalize((diy_fp){ (v.f << 1) + 1, v.e - 1 });
+	diy_fp minus = (v.f == DOUBLE_HIDDEN_BIT)
+		? (diy_fp){ (v.f << 2) - 1, v.e - 2 }
+		: (diy_fp){ (v.f << 1) - 1, v.e - 1 };
+	minus.f <<= minus.e - plus.e;
+	minus.e  = plus.e;
+
+	diy_fp c_mk = cached_power(plus.e, k);
+	diy_fp w  = diy_fp_mult(diy_fp_normalize(v), c_mk);
+	diy_fp wp = diy_fp_mult(plus, c_mk);
+	diy_fp wm = diy_fp_mult(minus, c_mk);
+	wm.f++;
+	wp.f--;
+
+	return grisu_digit_gen(w, wp, wp.f - wm.f, digits, k);
 }
 
-void link_insert(struct link *new_link, struct link *before_this)
+// Lay out len digits with decimal exponent k like JavaScript does:
+// plain notation for 1e-7 < |d| < 1e21, otherwise d.ddde[-]x.
+static int double_layout(char *out, const char *digits, int len, int k)
 {
-	link_attach(link_prev(before_this), new_link);
-	link_attach(new_link, before_this);
+	int point = len + k;    // digits before the decimal point
+	char *p = out;
+
+	if (0 <= k && point <= 21) {
+		memcpy(p, digits, len);
+		memset(p + len, '0', k);
+		p += point;
+	}
+	else if (0 < point && point <= 21) {
+		memcpy(p, digits, point);
+		p[point] = '.';
+		memcpy(p + point + 1, digits + point, len - point);
+		p += len + 1;
+	}
+	else if (-6 < point && point <= 0) {
+		*p++ = '0';
+		*p++ = '.';
+		memset(p, '0', -point);
+		memcpy(p - point, digits, len);
+		p += len - point;
+	}
+	else {
+		*p++ = digits[0];
+		if (len > 1) {
+			*p++ = '.';
+			memcpy(p, digits + 1, len - 1);
+			p += len - 1;
+		}
+		*p++ = 'e';
+		p += int32_to_str(p, point - 1);
+	}
+
+	*p = '\0';
+	return p - out;
 }
 
-void link_append(struct link *after_this, struct link *new_link)
+int double_to_str(char *out, double d)
 {
-	link_attach(new_link, link_next(after_this));
-	link_attach(after_this, new_link);
+	char *p = out;
+
+	if (isnan(d))
+		return strcpy(out, "nan"), 3;
+
+	if (signbit(d)) {
+		*p++ = '-';
+		d = -d;
+	}
+
+	if (isinf(d))
+		return strcpy(p, "inf"), p - out + 3;
+
+	if (d == 0.0)
+		return strcpy(p, "0"), p - out + 1;
+
+	char digits[20];
+	int k = 0;
+	int len = grisu2(d, digits, &k);
+	return p - out + double_layout(p, digits, len, k);
 }
 
-void link_remove(struct link *n)
+enum status strbuf_put_int(struct strbuf *buf, int64_t n)
 {
-	link_attach(link_prev(n), link_next(n));
-	n->next = n->prev = NULL;
+	char digits[INT_STR_SIZE];
+	int len = int64_to_str(digits, n);
+	return strbuf_cat(buf, strand_init_n(digits, len));
 }
 
-bool Chain_empty(const Chain * const chain)
+enum status strbuf_put_uint(struct strbuf *buf, uint64_t n)
 {
-	return !chain || chain->head.next == &chain->head;
+	char digits[INT_STR_SIZE];
+	int len = uint64_to_str(digits, n);
+	return strbuf_cat(buf, strand_init_n(digits, len));
 }
 
-struct link *Chain_first(Chain *chain)
+enum status strbuf_put_double(struct strbuf *buf, double d)
 {
-	return Chain_empty(chain) ? NULL : chain->head.next;
+	char digits[DOUBLE_STR_SIZE];
+	int len = double_to_str(digits, d);
+	return strbuf_cat(buf, strand_init_n(digits, len));
 }
 
-struct link *Chain_last(Chain *chain)
+//----------------------------------------------------------------------
+// Number parsing Module
+
+// Parse a run of decimal digits into *value, checking for overflow only
+// once more than 19 digits (which always fit) have been read.
+static enum status parse_digits(const char *p, const char *end, uint64_t *value, int *used)
 {
-	return Chain_empty(chain) ? NULL : chain->head.prev;
+	const char *front = p;
+	uint64_t n = 0;
+
+	for (; p < end && p - front < 19 && isdigit((unsigned char)*p); ++p)
+		n = n * 10 + (*p - '0');
+
+	enum status stat = STATUS_OK;
+	for (; p < end && isdigit((unsigned char)*p); ++p) {
+		if (uint64_mult_overflows(n, 10) || uint64_add_overflows(n * 10, *p - '0'))
+			stat = STATUS_MATH_OVERFLOW;
+		else
+			n = n * 10 + (*p - '0');
+	}
+
+	*used = p - front;
+	if (*used == 0)
+		return STATUS_ERROR;
+	if (stat == STATUS_OK)
+		*value = n;
+	return stat;
 }
 
-void  Chain_prepend(Chain *c, struct link *l)
+enum status parse_uint64(struct strand s, uint64_t *value, int *used)
 {
-	link_append(&c->head, l);
+	int n = 0;
+	enum status stat = parse_digits(s.front, s.back, value, &n);
+	if (used)  *used = n;
+	return stat;
 }
 
-void Chain_append(Chain *c, struct link *l)
+enum status parse_int64(struct strand s, int64_t *value, int *used)
 {
-	link_insert(l, &c->head);
+	const char *p = s.front;
+	bool negative = (p < s.back && *p == '-');
+	if (p < s.back && (*p == '-' || *p == '+'))
+		++p;
+
+	uint64_t mag = 0;
+	int n = 0;
+	enum status stat = parse_digits(p, s.back, &mag, &n);
+
+	if (stat == STATUS_OK && mag > (uint64_t)INT64_MAX + negative)
+		stat = STATUS_MATH_OVERFLOW;
+	if (stat == STATUS_OK)
+		*value = negative ? (int64_t)(0 - mag) : (int64_t)mag;
+
+	if (used)  *used = n ? (p - s.front) + n : 0;
+	return stat;
 }
 
-void Chain_appends(Chain *chain, ...)
-{
-	va_list args;
-	va_start(args, chain);
+// Unsigned results only need the upper bound checked; n < 0 would always
+// be false and draws -Wtype-limits.
+#define PARSE_UINT_TEMPLATE(TYPE_, PRE_, MAX_) \
+	enum status parse_##PRE_(struct strand s, TYPE_ *value, int *used) { \
+		uint64_t n = 0; \
+		enum status stat = parse_uint64(s, &n, used); \
+		if (stat == STATUS_OK && n > (MAX_)) \
+			stat = STATUS_MATH_OVERFLOW; \
+		if (stat == STATUS_OK) \
+			*value = (TYPE_)n; \
+		return stat; }
 
-	struct link *prev = &chain->head;
-	struct link *next = NULL;
-	while ((next = va_arg(args, struct link*)))
-		prev = link_attach(prev, next);
-	link_attach(prev, &chain->head);
+#define PARSE_INT_TEMPLATE(TYPE_, PRE_, MIN_, MAX_) \
+	enum status parse_##PRE_(struct strand s, TYPE_ *value, int *used) { \
+		int64_t n = 0; \
+		enum status stat = parse_int64(s, &n, used); \
+		if (stat == STATUS_OK && (n < (MIN_) || n > (MAX_))) \
+			stat = STATUS_MATH_OVERFLOW; \
+		if (stat == STATUS_OK) \
+			*value = (TYPE_)n; \
+		return stat; }
 
-	va_end(args);
+PARSE_UINT_TEMPLATE(uint32_t, uint32, UINT32_MAX)
+PARSE_UINT_TEMPLATE(uint16_t, uint16, UINT16_MAX)
+PARSE_UINT_TEMPLATE(uint8_t,  uint8,  UINT8_MAX)
+PARSE_INT_TEMPLATE(int32_t,  int32,  INT32_MIN, INT32_MAX)
+PARSE_INT_TEMPLATE(int16_t,  int16,  INT16_MIN, INT16_MAX)
+PARSE_INT_TEMPLATE(int8_t,   int8,   INT8_MIN,  INT8_MAX)
+
+// Eisel-Lemire decimal to double conversion, after Daniel Lemire,
+// "Number Parsing at a Gigabyte per Second" (2021). Each entry is the
+// normalized 128-bit value of 5^q for q = -325..308, truncated for q >= 0
+// and rounded up for q < 0.
+
+enum { POW5_MIN_EXP = -325, POW5_MAX_EXP = 308 };
+
+static const uint64_t POW5_128[][2] = {
+	{ 0xa5ced43b7e3e9188ull, 0x419ea3bd35385e2dull },
+	{ 0xcf42894a5dce35eaull, 0x52064cac828675b9ull },
+	{ 0x818995ce7aa0e1b2ull, 0x7343efebd1940993ull },
+	{ 0xa1ebfb4219491a1full, 0x1014ebe6c5f90bf8ull },
+	{ 0xca66fa129f9b60a6ull, 0xd41a26e077774ef6ull },
+	{ 0xfd00b897478238d0ull, 0x8920b098955522b4ull },
+	{ 0x9e20735e8cb16382ull, 0x55b46e5f5d5535b0ull },
+	{ 0xc5a890362fddbc62ull, 0xeb2189f734aa831dull },
+	{ 0xf712b443bbd52b7bull, 0xa5e9ec7501d523e4ull },
+	{ 0x9a6bb0aa55653b2dull, 0x47b233c92125366eull },
+	{ 0xc1069cd4eabe89f8ull, 0x999ec0bb696e840aull },
+	{ 0xf148440a256e2c76ull, 0xc00670ea43ca250dull },
+	{ 0x96cd2a865764dbcaull, 0x380406926a5e5728ull },
+	{ 0xbc807527ed3e12bcull, 0xc605083704f5ecf2ull },
+	{ 0xeba09271e88d976bull, 0xf7864a44c633682eull },
+	{ 0x93445b8731587ea3ull, 0x7ab3ee6afbe0211dull },
+	{ 0xb8157268fdae9e4cull, 0x5960ea05bad82964ull },
+	{ 0xe61acf033d1a45dfull, 0x6fb92487298e33bdull },
+	{ 0x8fd0c16206306babull, 0xa5d3b6d479f8e056ull },
+	{ 0xb3c4f1ba87bc8696ull, 0x8f48a4899877186cull },
+	{ 0xe0b62e2929aba83cull, 0x331acdabfe94de87ull },
+	{ 0x8c71dcd9ba0b4925ull, 0x9ff0c08b7f1d0b14ull },
+	{ 0xaf8e5410288e1b6full, 0x07ecf0ae5ee44dd9ull },
+	{ 0xdb71e91432b1a24aull, 0xc9e82cd9f69d6150ull },
+	{ 0x892731ac9faf056eull, 0xbe311c083a225cd2ull },
+	{ 0xab70fe17c79ac6caull, 0x6dbd630a48aaf406ull },
+	{ 0xd64d3d9db981787dull, 0x092cbbccdad5b108ull },
+	{ 0x85f0468293f0eb4eull, 0x25bbf56008c58ea5ull },
+	{ 0xa76c582338ed2621ull, 0xaf2af2b80af6f24eull },
+	{ 0xd1476e2c07286faaull, 0x1af5af660db4aee1ull },
+	{ 0x82cca4db847945caull, 0x50d98d9fc890ed4dull },
+	{ 0xa37fce126597973cull, 0xe50ff107bab528a0ull },
+	{ 0xcc5fc196fefd7d0cull, 0x1e53ed49a96272c8ull },
+	{ 0xff77b1fcbebcdc4full, 0x25e8e89c13bb0f7aull },
+	{ 0x9faacf3df73609b1ull, 0x77b191618c54e9acull },
+	{ 0xc795830d75038c1dull, 0xd59df5b9ef6a2417ull },
+	{ 0xf97ae3d0d2446f25ull, 0x4b0573286b44ad1dull },
+	{ 0x9becce62836ac577ull, 0x4ee367f9430aec32ull },
+	{ 0xc2e801fb244576d5ull, 0x229c41f793cda73full },
+	{ 0xf3a20279ed56d48aull, 0x6b43527578c1110full },
+	{ 0x9845418c345644d6ull, 0x830a13896b78aaa9ull },
+	{ 0xbe5691ef416bd60cull, 0x23cc986bc656d553ull },
+	{ 0xedec366b11c6cb8full, 0x2cbfbe86b7ec8aa8ull },
+	{ 0x94b3a202eb1c3f39ull, 0x7bf7d71432f3d6a9ull },
+	{ 0xb9e08a83a5e34f07ull, 0xdaf5ccd93fb0cc53ull },
+	{ 0xe858ad248f5c22c9ull, 0xd1b3400f8f9cff68ull },
+	{ 0x91376c36d99995beull, 0x23100809b9c21fa1ull },
+	{ 0xb58547448ffffb2dull, 0xabd40a0c2832a78aull },
+	{ 0xe2e69915b3fff9f9ull, 0x16c90c8f323f516cull },
+	{ 0x8dd01fad907ffc3bull, 0xae3da7d97f6792e3ull },
+	{ 0xb1442798f49ffb4aull, 0x99cd11cfdf41779cull },
+	{ 0xdd95317f31c7fa1dull, 0x40405643d711d583ull },
+	{ 0x8a7d3eef7f1cfc52ull, 0x482835ea666b2572ull },
+	{ 0xad1c8eab5ee43b66ull, 0xda3243650005eecfull },
+	{ 0xd863b256369d4a40ull, 0x90bed43e40076a82ull },
+	{ 0x873e4f75e2224e68ull, 0x5a7744a6e804a291ull },
+	{ 0xa90de3535aaae202ull, 0x711515d0a205cb36ull },
+	{ 0xd3515c2831559a83ull, 0x0d5a5b44ca873e03ull },
+	{ 0x8412d9991ed58091ull, 0xe858790afe9486c2ull },
+	{ 0xa5178fff668ae0b6ull, 0x626e974dbe39a872ull },
+	{ 0xce5d73ff402d98e3ull, 0xfb0a3d212dc8128full },
+	{ 0x80fa687f881c7f8eull, 0x7ce66634bc9d0b99ull },
+	{ 0xa139029f6a239f72ull, 0x1c1fffc1ebc44e80ull },
+	{ 0xc987434744ac874eull, 0xa327ffb266b56220ull },
+	{ 0xfbe9141915d7a922ull, 0x4bf1ff9f0062baa8ull },
+	{ 0x9d71ac8fada6c9b5ull, 0x6f773fc3603db4a9ull },
+	{ 0xc4ce17b399107c22ull, 0xcb550fb4384d21d3ull },
+	{ 0xf6019da07f549b2bull, 0x7e2a53a146606a48ull },
+	{ 0x99c102844f94e0fbull, 0x2eda7444cbfc426dull },
+	{ 0xc0314325637a1939ull, 0xfa911155fefb5308ull },
+	{ 0xf03d93eebc589f88ull, 0x793555ab7eba27caull },
+	{ 0x96267c7535b763b5ull, 0x4bc1558b2f3458deull },
+	{ 0xbbb01b9283253ca2ull, 0x9eb1aaedfb016f16ull },
+	{ 0xea9c227723ee8bcbull, 0x465e15a979c1cadcull },
+	{ 0x92a1958a7675175full, 0x0bfacd89ec191ec9ull },
+	{ 0xb749faed14125d36ull, 0xcef980ec671f667bull },
+	{ 0xe51c79a85916f484ull, 0x82b7e12780e7401aull },
+	{ 0x8f31cc0937ae58d2ull, 0xd1b2ecb8b0908810ull },
+	{ 0xb2fe3f0b8599ef07ull, 0x861fa7e6dcb4aa15ull },
+	{ 0xdfbdcece67006ac9ull, 0x67a791e093e1d49aull },
+	{ 0x8bd6a141006042bdull, 0xe0c8bb2c5c6d24e0ull },
+	{ 0xaecc49914078536dull, 0x58fae9f773886e18ull },
+	{ 0xda7f5bf590966848ull, 0xaf39a475506a899eull },
+	{ 0x888f99797a5e012dull, 0x6d8406c952429603ull },
+	{ 0xaab37fd7d8f58178ull, 0xc8e5087ba6d33b83ull },
+	{ 0xd5605fcdcf32e1d6ull, 0xfb1e4a9a90880a64ull },
+	{ 0x855c3be0a17fcd26ull, 0x5cf2eea09a55067full },
+	{ 0xa6b34ad8c9dfc06full, 0xf42faa48c0ea481eull },
+	{ 0xd0601d8efc57b08bull, 0xf13b94daf124da26ull },
+	{ 0x823c12795db6ce57ull, 0x76c53d08d6b70858ull },
+	{ 0xa2cb1717b52481edull, 0x54768c4b0c64ca6eull },
+	{ 0xcb7ddcdda26da268ull, 0xa9942f5dcf7dfd09ull },
+	{ 0xfe5d54150b090b02ull, 0xd3f93b35435d7c4cull },
+	{ 0x9efa548d26e5a6e1ull, 0xc47bc5014a1a6dafull },
+	{ 0xc6b8e9b0709f109aull, 0x359ab6419ca1091bull },
+	{ 0xf867241c8cc6d4c0ull, 0xc30163d203c94b62ull },
+	{ 0x9b407691d7fc44f8ull, 0x79e0de63425dcf1dull },
+	{ 0xc21094364dfb5636ull, 0x985915fc12f542e4ull },
+	{ 0xf294b943e17a2bc4ull, 0x3e6f5b7b17b2939dull },
+	{ 0x979cf3ca6cec5b5aull, 0xa705992ceecf9c42ull },
+	{ 0xbd8430bd08277231ull, 0x50c6ff782a838353ull },
+	{ 0xece53cec4a314ebdull, 0xa4f8bf5635246428ull },
+	{ 0x940f4613ae5ed136ull, 0x871b7795e136be99ull },
+	{ 0xb913179899f68584ull, 0x28e2557b59846e3full },
+	{ 0xe757dd7ec07426e5ull, 0x331aeada2fe589cfull },
+	{ 0x9096ea6f3848984full, 0x3ff0d2c85def7621ull },
+	{ 0xb4bca50b065abe63ull, 0x0fed077a756b53a9ull },
+	{ 0xe1ebce4dc7f16dfbull, 0xd3e8495912c62894ull },
+	{ 0x8d3360f09cf6e4bdull, 0x64712dd7abbbd95cull },
+	{ 0xb080392cc4349decull, 0xbd8d794d96aacfb3ull },
+	{ 0xdca04777f541c567ull, 0xecf0d7a0fc5583a0ull },
+	{ 0x89e42caaf9491b60ull, 0xf41686c49db57244ull },
+	{ 0xac5d37d5b79b6239ull, 0x311c2875c522ced5ull },
+	{ 0xd77485cb25823ac7ull, 0x7d633293366b828bull },
+	{ 0x86a8d39ef77164bcull, 0xae5dff9c02033197ull },
+	{ 0xa8530886b54dbdebull, 0xd9f57f830283fdfcull },
+	{ 0xd267caa862a12d66ull, 0xd072df63c324fd7bull },
+	{ 0x8380dea93da4bc60ull, 0x4247cb9e59f71e6dull },
+	{ 0xa46116538d0deb78ull, 0x52d9be85f074e608ull },
+	{ 0xcd795be870516656ull, 0x67902e276c921f8bull },
+	{ 0x806bd9714632dff6ull, 0x00ba1cd8a3db53b6ull },
+	{ 0xa086cfcd97bf97f3ull, 0x80e8a40eccd228a4ull },
+	{ 0xc8a883c0fdaf7df0ull, 0x6122cd128006b2cdull },
+	{ 0xfad2a4b13d1b5d6cull, 0x796b805720085f81ull },
+	{ 0x9cc3a6eec6311a63ull, 0xcbe3303674053bb0ull },
+	{ 0xc3f490aa77bd60fcull, 0xbedbfc4411068a9cull },
+	{ 0xf4f1b4d515acb93bull, 0xee92fb5515482d44ull },
+	{ 0x991711052d8bf3c5ull, 0x751bdd152d4d1c4aull },
+	{ 0xbf5cd54678eef0b6ull, 0xd262d45a78a0635dull },
+	{ 0xef340a98172aace4ull, 0x86fb897116c87c34ull },
+	{ 0x9580869f0e7aac0eull, 0xd45d35e6ae3d4da0ull },
+	{ 0xbae0a846d2195712ull, 0x8974836059cca109ull },
+	{ 0xe998d258869facd7ull, 0x2bd1a438703fc94bull },
+	{ 0x91ff83775423cc06ull, 0x7b6306a34627ddcfull },
+	{ 0xb67f6455292cbf08ull, 0x1a3bc84c17b1d542ull },
+	{ 0xe41f3d6a7377eecaull, 0x20caba5f1d9e4a93ull },
+	{ 0x8e938662882af53eull, 0x547eb47b7282ee9cull },
+	{ 0xb23867fb2a35b28dull, 0xe99e619a4f23aa43ull },
+	{ 0xdec681f9f4c31f31ull, 0x6405fa00e2ec94d4ull },
+	{ 0x8b3c113c38f9f37eull, 0xde83bc408dd3dd04ull },
+	{ 0xae0b158b4738705eull, 0x9624ab50b148d445ull },
+	{ 0xd98ddaee19068c76ull, 0x3badd624dd9b0957ull },
+	{ 0x87f8a8d4cfa417c9ull, 0xe54ca5d70a80e5d6ull },
+	{ 0xa9f6d30a038d1dbcull, 0x5e9fcf4ccd211f4cull },
+	{ 0xd47487cc8470652bull, 0x7647c3200069671full },
+	{ 0x84c8d4dfd2c63f3bull, 0x29ecd9f40041e073ull },
+	{ 0xa5fb0a17c777cf09ull, 0xf468107100525890ull },
+	{ 0xcf79cc9db955c2ccull, 0x7182148d4066eeb4ull },
+	{ 0x81ac1fe293d599bfull, 0xc6f14cd848405530ull },
+	{ 0xa21727db38cb002full, 0xb8ada00e5a506a7cull },
+	{ 0xca9cf1d206fdc03bull, 0xa6d90811f0e4851cull },
+	{ 0xfd442e4688bd304aull, 0x908f4a166d1da663ull },
+	{ 0x9e4a9cec15763e2eull, 0x9a598e4e043287feull },
+	{ 0xc5dd44271ad3cdbaull, 0x40eff1e1853f29fdull },
+	{ 0xf7549530e188c128ull, 0xd12bee59e68ef47cull },
+	{ 0x9a94dd3e8cf578b9ull, 0x82bb74f8301958ceull },
+	{ 0xc13a148e3032d6e7ull, 0xe36a52363c1faf01ull },
+	{ 0xf18899b1bc3f8ca1ull, 0xdc44e6c3cb279ac1ull },
+	{ 0x96f5600f15a7b7e5ull, 0x29ab103a5ef8c0b9ull },
+	{ 0xbcb2b812db11a5deull, 0x7415d448f6b6f0e7ull },
+	{ 0xebdf661791d60f56ull, 0x111b495b3464ad21ull },
+	{ 0x936b9fcebb25c995ull, 0xcab10dd900beec34ull },
+	{ 0xb84687c269ef3bfbull, 0x3d5d514f40eea742ull },
+	{ 0xe65829b3046b0afaull, 0x0cb4a5a3112a5112ull },
+	{ 0x8ff71a0fe2c2e6dcull, 0x47f0e785eaba72abull },
+	{ 0xb3f4e093db73a093ull, 0x59ed216765690f56ull },
+	{ 0xe0f218b8d25088b8ull, 0x306869c13ec3532cull },
+	{ 0x8c974f7383725573ull, 0x1e414218c73a13fbull },
+	{ 0xafbd2350644eeacfull, 0xe5d1929ef90898faull },
+	{ 0xdbac6c247d62a583ull, 0xdf45f746b74abf39ull },
+	{ 0x894bc396ce5da772ull, 0x6b8bba8c328eb783ull },
+	{ 0xab9eb47c81f5114full, 0x066ea92f3f326564ull },
+	{ 0xd686619ba27255a2ull, 0xc80a537b0efefebdull },
+	{ 0x8613fd0145877585ull, 0xbd06742ce95f5f36ull },
+	{ 0xa798fc4196e952e7ull, 0x2c48113823b73704ull },
+	{ 0xd17f3b51fca3a7a0ull, 0xf75a15862ca504c5ull },
+	{ 0x82ef85133de648c4ull, 0x9a984d73dbe722fbull },
+	{ 0xa3ab66580d5fdaf5ull, 0xc13e60d0d2e0ebbaull },
+	{ 0xcc963fee10b7d1b3ull, 0x318df905079926a8ull },
+	{ 0xffbbcfe994e5c61full, 0xfdf17746497f7052ull },
+	{ 0x9fd561f1fd0f9bd3ull, 0xfeb6ea8bedefa633ull },
+	{ 0xc7caba6e7c5382c8ull, 0xfe64a52ee96b8fc0ull },
+	{ 0xf9bd690a1b68637bull, 0x3dfdce7aa3c673b0ull },
+	{ 0x9c1661a651213e2dull, 0x06bea10ca65c084eull },
+	{ 0xc31bfa0fe5698db8ull, 0x486e494fcff30a62ull },
+	{ 0xf3e2f893dec3f126ull, 0x5a89dba3c3efccfaull },
+	{ 0x986ddb5c6b3a76b7ull, 0xf89629465a75e01cull },
+	{ 0xbe89523386091465ull, 0xf6bbb397f1135823ull },
+	{ 0xee2ba6c0678b597full, 0x746aa07ded582e2cull },
+	{ 0x94db483840b717efull, 0xa8c2a44eb4571cdcull },
+	{ 0xba121a4650e4ddebull, 0x92f34d62616ce413ull },
+	{ 0xe896a0d7e51e1566ull, 0x77b020baf9c81d17ull },
+	{ 0x915e2486ef32cd60ull, 0x0ace1474dc1d122eull },
+	{ 0xb5b5ada8aaff80b8ull, 0x0d819992132456baull },
+	{ 0xe3231912d5bf60e6ull, 0x10e1fff697ed6c69ull },
+	{ 0x8df5efabc5979c8full, 0xca8d3ffa1ef463c1ull },
+	{ 0xb1736b96b6fd83b3ull, 0xbd308ff8a6b17cb2ull },
+	{ 0xddd0467c64bce4a0ull, 0xac7cb3f6d05ddbdeull },
+	{ 0x8aa22c0dbef60ee4ull, 0x6bcdf07a423aa96bull },
+	{ 0xad4ab7112eb3929dull, 0x86c16c98d2c953c6ull },
+	{ 0xd89d64d57a607744ull, 0xe871c7bf077ba8b7ull },
+	{ 0x87625f056c7c4a8bull, 0x11471cd764ad4972ull },
+	{ 0xa93af6c6c79b5d2dull, 0xd598e40d3dd89bcfull },
+	{ 0xd389b47879823479ull, 0x4aff1d108d4ec2c3ull },
+	{ 0x843610cb4bf160cbull, 0xcedf722a585139baull },
+	{ 0xa54394fe1eedb8feull, 0xc2974eb4ee658828ull },
+	{ 0xce947a3da6a9273eull, 0x733d226229feea32ull },
+	{ 0x811ccc668829b887ull, 0x0806357d5a3f525full },
+	{ 0xa163ff802a3426a8ull, 0xca07c2dcb0cf26f7ull },
+	{ 0xc9bcff6034c13052ull, 0xfc89b393dd02f0b5ull },
+	{ 0xfc2c3f3841f17c67ull, 0xbbac2078d443ace2ull },
+	{ 0x9d9ba7832936edc0ull, 0xd54b944b84aa4c0dull },
+	{ 0xc5029163f384a931ull, 0x0a9e795e65d4df11ull },
+	{ 0xf64335bcf065d37dull, 0x4d4617b5ff4a16d5ull },
+	{ 0x99ea0196163fa42eull, 0x504bced1bf8e4e45ull },
+	{ 0xc06481fb9bcf8d39ull, 0xe45ec2862f71e1d6ull },
+	{ 0xf07da27a82c37088ull, 0x5d767327bb4e5a4cull },
+	{ 0x964e858c91ba2655ull, 0x3a6a07f8d510f86full },
+	{ 0xbbe226efb628afeaull, 0x890489f70a55368bull },
+	{ 0xeadab0aba3b2dbe5ull, 0x2b45ac74ccea842eull },
+	{ 0x92c8ae6b464fc96full, 0x3b0b8bc90012929dull },
+	{ 0xb77ada0617e3bbcbull, 0x09ce6ebb40173744ull },
+	{ 0xe55990879ddcaabdull, 0xcc420a6a101d0515ull },
+	{ 0x8f57fa54c2a9eab6ull, 0x9fa946824a12232dull },
+	{ 0xb32df8e9f3546564ull, 0x47939822dc96abf9ull },
+	{ 0xdff9772470297ebdull, 0x59787e2b93bc56f7ull },
+	{ 0x8bfbea76c619ef36ull, 0x57eb4edb3c55b65aull },
+	{ 0xaefae51477a06b03ull, 0xede622920b6b23f1ull },
+	{ 0xdab99e59958885c4ull, 0xe95fab368e45ecedull },
+	{ 0x88b402f7fd75539bull, 0x11dbcb0218ebb414ull },
+	{ 0xaae103b5fcd2a881ull, 0xd652bdc29f26a119ull },
+	{ 0xd59944a37c0752a2ull, 0x4be76d3346f0495full },
+	{ 0x857fcae62d8493a5ull, 0x6f70a4400c562ddbull },
+	{ 0xa6dfbd9fb8e5b88eull, 0xcb4ccd500f6bb952ull },
+	{ 0xd097ad07a71f26b2ull, 0x7e2000a41346a7a7ull },
+	{ 0x825ecc24c873782full, 0x8ed400668c0c28c8ull },
+	{ 0xa2f67f2dfa90563bull, 0x728900802f0f32faull },
+	{ 0xcbb41ef979346bcaull, 0x4f2b40a03ad2ffb9ull },
+	{ 0xfea126b7d78186bcull, 0xe2f610c84987bfa8ull },
+	{ 0x9f24b832e6b0f436ull, 0x0dd9ca7d2df4d7c9ull },
+	{ 0xc6ede63fa05d3143ull, 0x91503d1c79720dbbull },
+	{ 0xf8a95fcf88747d94ull, 0x75a44c6397ce912aull },
+	{ 0x9b69dbe1b548ce7cull, 0xc986afbe3ee11abaull },
+	{ 0xc24452da229b021bull, 0xfbe85badce996168ull },
+	{ 0xf2d56790ab41c2a2ull, 0xfae27299423fb9c3ull },
+	{ 0x97c560ba6b0919a5ull, 0xdccd879fc967d41aull },
+	{ 0xbdb6b8e905cb600full, 0x5400e987bbc1c920ull },
+	{ 0xed246723473e3813ull, 0x290123e9aab23b68ull },
+	{ 0x9436c0760c86e30bull, 0xf9a0b6720aaf6521ull },
+	{ 0xb94470938fa89bceull, 0xf808e40e8d5b3e69ull },
+	{ 0xe7958cb87392c2c2ull, 0xb60b1d1230b20e04ull },
+	{ 0x90bd77f3483bb9b9ull, 0xb1c6f22b5e6f48c2ull },
+	{ 0xb4ecd5f01a4aa828ull, 0x1e38aeb6360b1af3ull },
+	{ 0xe2280b6c20dd5232ull, 0x25c6da63c38de1b0ull },
+	{ 0x8d590723948a535full, 0x579c487e5a38ad0eull },
+	{ 0xb0af48ec79ace837ull, 0x2d835a9df0c6d851ull },
+	{ 0xdcdb1b2798182244ull, 0xf8e431456cf88e65ull },
+	{ 0x8a08f0f8bf0f156bull, 0x1b8e9ecb641b58ffull },
+	{ 0xac8b2d36eed2dac5ull, 0xe272467e3d222f3full },
+	{ 0xd7adf884aa879177ull, 0x5b0ed81dcc6abb0full },
+	{ 0x86ccbb52ea94baeaull, 0x98e947129fc2b4e9ull },
+	{ 0xa87fea27a539e9a5ull, 0x3f2398d747b36224ull },
+	{ 0xd29fe4b18e88640eull, 0x8eec7f0d19a03aadull },
+	{ 0x83a3eeeef9153e89ull, 0x1953cf68300424acull },
+	{ 0xa48ceaaab75a8e2bull, 0x5fa8c3423c052dd7ull },
+	{ 0xcdb02555653131b6ull, 0x3792f412cb06794dull },
+	{ 0x808e17555f3ebf11ull, 0xe2bbd88bbee40bd0ull },
+	{ 0xa0b19d2ab70e6ed6ull, 0x5b6aceaeae9d0ec4ull },
+	{ 0xc8de047564d20a8bull, 0xf245825a5a445275ull },
+	{ 0xfb158592be068d2eull, 0xeed6e2f0f0d56712ull },
+	{ 0x9ced737bb6c4183dull, 0x55464dd69685606bull },
+	{ 0xc428d05aa4751e4cull, 0xaa97e14c3c26b886ull },
+	{ 0xf53304714d9265dfull, 0xd53dd99f4b3066a8ull },
+	{ 0x993fe2c6d07b7fabull, 0xe546a8038efe4029ull },
+	{ 0xbf8fdb78849a5f96ull, 0xde98520472bdd033ull },
+	{ 0xef73d256a5c0f77cull, 0x963e66858f6d4440ull },
+	{ 0x95a8637627989aadull, 0xdde7001379a44aa8ull },
+	{ 0xbb127c53b17ec159ull, 0x5560c018580d5d52ull },
+	{ 0xe9d71b689dde71afull, 0xaab8f01e6e10b4a6ull },
+	{ 0x9226712162ab070dull, 0xcab3961304ca70e8ull },
+	{ 0xb6b00d69bb55c8d1ull, 0x3d607b97c5fd0d22ull },
+	{ 0xe45c10c42a2b3b05ull, 0x8cb89a7db77c506aull },
+	{ 0x8eb98a7a9a5b04e3ull, 0x77f3608e92adb242ull },
+	{ 0xb267ed1940f1c61cull, 0x55f038b237591ed3ull },
+	{ 0xdf01e85f912e37a3ull, 0x6b6c46dec52f6688ull },
+	{ 0x8b61313bbabce2c6ull, 0x2323ac4b3b3da015ull },
+	{ 0xae397d8aa96c1b77ull, 0xabec975e0a0d081aull },
+	{ 0xd9c7dced53c72255ull, 0x96e7bd358c904a21ull },
+	{ 0x881cea14545c7575ull, 0x7e50d64177da2e54ull },
+	{ 0xaa242499697392d2ull, 0xdde50bd1d5d0b9e9ull },
+	{ 0xd4ad2dbfc3d07787ull, 0x955e4ec64b44e864ull },
+	{ 0x84ec3c97da624ab4ull, 0xbd5af13bef0b113eull },
+	{ 0xa6274bbdd0fadd61ull, 0xecb1ad8aeacdd58eull },
+	{ 0xcfb11ead453994baull, 0x67de18eda5814af2ull },
+	{ 0x81ceb32c4b43fcf4ull, 0x80eacf948770ced7ull },
+	{ 0xa2425ff75e14fc31ull, 0xa1258379a94d028dull },
+	{ 0xcad2f7f5359a3b3eull, 0x096ee45813a04330ull },
+	{ 0xfd87b5f28300ca0dull, 0x8bca9d6e188853fcull },
+	{ 0x9e74d1b791e07e48ull, 0x775ea264cf55347eull },
+	{ 0xc612062576589ddaull, 0x95364afe032a819eull },
+	{ 0xf79687aed3eec551ull, 0x3a83ddbd83f52205ull },
+	{ 0x9abe14cd44753b52ull, 0xc4926a9672793543ull },
+	{ 0xc16d9a0095928a27ull, 0x75b7053c0f178294ull },
+	{ 0xf1c90080baf72cb1ull, 0x5324c68b12dd6339ull },
+	{ 0x971da05074da7beeull, 0xd3f6fc16ebca5e04ull },
+	{ 0xbce5086492111aeaull, 0x88f4bb1ca6bcf585ull },
+	{ 0xec1e4a7db69561a5ull, 0x2b31e9e3d06c32e6ull },
+	{ 0x9392ee8e921d5d07ull, 0x3aff322e62439fd0ull },
+	{ 0xb877aa3236a4b449ull, 0x09befeb9fad487c3ull },
+	{ 0xe69594bec44de15bull, 0x4c2ebe687989a9b4ull },
+	{ 0x901d7cf73ab0acd9ull, 0x0f9d37014bf60a11ull },
+	{ 0xb424dc35095cd80full, 0x538484c19ef38c95ull },
+	{ 0xe12e13424bb40e13ull, 0x2865a5f206b06fbaull },
+	{ 0x8cbccc096f5088cbull, 0xf93f87b7442e45d4ull },
+	{ 0xafebff0bcb24aafeull, 0xf78f69a51539d749ull },
+	{ 0xdbe6fecebdedd5beull, 0xb573440e5a884d1cull },
+	{ 0x89705f4136b4a597ull, 0x31680a88f8953031ull },
+	{ 0xabcc77118461cefcull, 0xfdc20d2b36ba7c3eull },
+	{ 0xd6bf94d5e57a42bcull, 0x3d32907604691b4dull },
+	{ 0x8637bd05af6c69b5ull, 0xa63f9a49c2c1b110ull },
+	{ 0xa7c5ac471b478423ull, 0x0fcf80dc33721d54ull },
+	{ 0xd1b71758e219652bull, 0xd3c36113404ea4a9ull },
+	{ 0x83126e978d4fdf3bull, 0x645a1cac083126eaull },
+	{ 0xa3d70a3d70a3d70aull, 0x3d70a3d70a3d70a4ull },
+	{ 0xccccccccccccccccull, 0xcccccccccccccccdull },
+	{ 0x8000000000000000ull, 0x0000000000000000ull },
+	{ 0xa000000000000000ull, 0x0000000000000000ull },
+	{ 0xc800000000000000ull, 0x0000000000000000ull },
+	{ 0xfa00000000000000ull, 0x0000000000000000ull },
+	{ 0x9c40000000000000ull, 0x0000000000000000ull },
+	{ 0xc350000000000000ull, 0x0000000000000000ull },
+	{ 0xf424000000000000ull, 0x0000000000000000ull },
+	{ 0x9896800000000000ull, 0x0000000000000000ull },
+	{ 0xbebc200000000000ull, 0x0000000000000000ull },
+	{ 0xee6b280000000000ull, 0x0000000000000000ull },
+	{ 0x9502f90000000000ull, 0x0000000000000000ull },
+	{ 0xba43b74000000000ull, 0x0000000000000000ull },
+	{ 0xe8d4a51000000000ull, 0x0000000000000000ull },
+	{ 0x9184e72a00000000ull, 0x0000000000000000ull },
+	{ 0xb5e620f480000000ull, 0x0000000000000000ull },
+	{ 0xe35fa931a0000000ull, 0x0000000000000000ull },
+	{ 0x8e1bc9bf04000000ull, 0x0000000000000000ull },
+	{ 0xb1a2bc2ec5000000ull, 0x0000000000000000ull },
+	{ 0xde0b6b3a76400000ull, 0x0000000000000000ull },
+	{ 0x8ac7230489e80000ull, 0x0000000000000000ull },
+	{ 0xad78ebc5ac620000ull, 0x0000000000000000ull },
+	{ 0xd8d726b7177a8000ull, 0x0000000000000000ull },
+	{ 0x878678326eac9000ull, 0x0000000000000000ull },
+	{ 0xa968163f0a57b400ull, 0x0000000000000000ull },
+	{ 0xd3c21bcecceda100ull, 0x0000000000000000ull },
+	{ 0x84595161401484a0ull, 0x0000000000000000ull },
+	{ 0xa56fa5b99019a5c8ull, 0x0000000000000000ull },
+	{ 0xcecb8f27f4200f3aull, 0x0000000000000000ull },
+	{ 0x813f3978f8940984ull, 0x4000000000000000ull },
+	{ 0xa18f07d736b90be5ull, 0x5000000000000000ull },
+	{ 0xc9f2c9cd04674edeull, 0xa400000000000000ull },
+	{ 0xfc6f7c4045812296ull, 0x4d00000000000000ull },
+	{ 0x9dc5ada82b70b59dull, 0xf020000000000000ull },
+	{ 0xc5371912364ce305ull, 0x6c28000000000000ull },
+	{ 0xf684df56c3e01bc6ull, 0xc732000000000000ull },
+	{ 0x9a130b963a6c115cull, 0x3c7f400000000000ull },
+	{ 0xc097ce7bc90715b3ull, 0x4b9f100000000000ull },
+	{ 0xf0bdc21abb48db20ull, 0x1e86d40000000000ull },
+	{ 0x96769950b50d88f4ull, 0x1314448000000000ull },
+	{ 0xbc143fa4e250eb31ull, 0x17d955a000000000ull },
+	{ 0xeb194f8e1ae525fdull, 0x5dcfab0800000000ull },
+	{ 0x92efd1b8d0cf37beull, 0x5aa1cae500000000ull },
+	{ 0xb7abc627050305adull, 0xf14a3d9e40000000ull },
+	{ 0xe596b7b0c643c719ull, 0x6d9ccd05d0000000ull },
+	{ 0x8f7e32ce7bea5c6full, 0xe4820023a2000000ull },
+	{ 0xb35dbf821ae4f38bull, 0xdda2802c8a800000ull },
+	{ 0xe0352f62a19e306eull, 0xd50b2037ad200000ull },
+	{ 0x8c213d9da502de45ull, 0x4526f422cc340000ull },
+	{ 0xaf298d050e4395d6ull, 0x9670b12b7f410000ull },
+	{ 0xdaf3f04651d47b4cull, 0x3c0cdd765f114000ull },
+	{ 0x88d8762bf324cd0full, 0xa5880a69fb6ac800ull },
+	{ 0xab0e93b6efee0053ull, 0x8eea0d047a457a00ull },
+	{ 0xd5d238a4abe98068ull, 0x72a4904598d6d880ull },
+	{ 0x85a36366eb71f041ull, 0x47a6da2b7f864750ull },
+	{ 0xa70c3c40a64e6c51ull, 0x999090b65f67d924ull },
+	{ 0xd0cf4b50cfe20765ull, 0xfff4b4e3f741cf6dull },
+	{ 0x82818f1281ed449full, 0xbff8f10e7a8921a4ull },
+	{ 0xa321f2d7226895c7ull, 0xaff72d52192b6a0dull },
+	{ 0xcbea6f8ceb02bb39ull, 0x9bf4f8a69f764490ull },
+	{ 0xfee50b7025c36a08ull, 0x02f236d04753d5b4ull },
+	{ 0x9f4f2726179a2245ull, 0x01d762422c946590ull },
+	{ 0xc722f0ef9d80aad6ull, 0x424d3ad2b7b97ef5ull },
+	{ 0xf8ebad2b84e0d58bull, 0xd2e0898765a7deb2ull },
+	{ 0x9b934c3b330c8577ull, 0x63cc55f49f88eb2full },
+	{ 0xc2781f49ffcfa6d5ull, 0x3cbf6b71c76b25fbull },
+	{ 0xf316271c7fc3908aull, 0x8bef464e3945ef7aull },
+	{ 0x97edd871cfda3a56ull, 0x97758bf0e3cbb5acull },
+	{ 0xbde94e8e43d0c8ecull, 0x3d52eeed1cbea317ull },
+	{ 0xed63a231d4c4fb27ull, 0x4ca7aaa863ee4bddull },
+	{ 0x945e455f24fb1cf8ull, 0x8fe8caa93e74ef6aull },
+	{ 0xb975d6b6ee39e436ull, 0xb3e2fd538e122b44ull },
+	{ 0xe7d34c64a9c85d44ull, 0x60dbbca87196b616ull },
+	{ 0x90e40fbeea1d3a4aull, 0xbc8955e946fe31cdull },
+	{ 0xb51d13aea4a488ddull, 0x6babab6398bdbe41ull },
+	{ 0xe264589a4dcdab14ull, 0xc696963c7eed2dd1ull },
+	{ 0x8d7eb76070a08aecull, 0xfc1e1de5cf543ca2ull },
+	{ 0xb0de65388cc8ada8ull, 0x3b25a55f43294bcbull },
+	{ 0xdd15fe86affad912ull, 0x49ef0eb713f39ebeull },
+	{ 0x8a2dbf142dfcc7abull, 0x6e3569326c784337ull },
+	{ 0xacb92ed9397bf996ull, 0x49c2c37f07965404ull },
+	{ 0xd7e77a8f87daf7fbull, 0xdc33745ec97be906ull },
+	{ 0x86f0ac99b4e8dafdull, 0x69a028bb3ded71a3ull },
+	{ 0xa8acd7c0222311bcull, 0xc40832ea0d68ce0cull },
+	{ 0xd2d80db02aabd62bull, 0xf50a3fa490c30190ull },
+	{ 0x83c7088e1aab65dbull, 0x792667c6da79e0faull },
+	{ 0xa4b8cab1a1563f52ull, 0x577001b891185938ull },
+	{ 0xcde6fd5e09abcf26ull, 0xed4c0226b55e6f86ull },
+	{ 0x80b05e5ac60b6178ull, 0x544f8158315b05b4ull },
+	{ 0xa0dc75f1778e39d6ull, 0x696361ae3db1c721ull },
+	{ 0xc913936dd571c84cull, 0x03bc3a19cd1e38e9ull },
+	{ 0xfb5878494ace3a5full, 0x04ab48a04065c723ull },
+	{ 0x9d174b2dcec0e47bull, 0x62eb0d64283f9c76ull },
+	{ 0xc45d1df942711d9aull, 0x3ba5d0bd324f8394ull },
+	{ 0xf5746577930d6500ull, 0xca8f44ec7ee36479ull },
+	{ 0x9968bf6abbe85f20ull, 0x7e998b13cf4e1ecbull },
+	{ 0xbfc2ef456ae276e8ull, 0x9e3fedd8c321a67eull },
+	{ 0xefb3ab16c59b14a2ull, 0xc5cfe94ef3ea101eull },
+	{ 0x95d04aee3b80ece5ull, 0xbba1f1d158724a12ull },
+	{ 0xbb445da9ca61281full, 0x2a8a6e45ae8edc97ull },
+	{ 0xea1575143cf97226ull, 0xf52d09d71a3293bdull },
+	{ 0x924d692ca61be758ull, 0x593c2626705f9c56ull },
+	{ 0xb6e0c377cfa2e12eull, 0x6f8b2fb00c77836cull },
+	{ 0xe498f455c38b997aull, 0x0b6dfb9c0f956447ull },
+	{ 0x8edf98b59a373fecull, 0x4724bd4189bd5eacull },
+	{ 0xb2977ee300c50fe7ull, 0x58edec91ec2cb657ull },
+	{ 0xdf3d5e9bc0f653e1ull, 0x2f2967b66737e3edull },
+	{ 0x8b865b215899f46cull, 0xbd79e0d20082ee74ull },
+	{ 0xae67f1e9aec07187ull, 0xecd8590680a3aa11ull },
+	{ 0xda01ee641a708de9ull, 0xe80e6f4820cc9495ull },
+	{ 0x884134fe908658b2ull, 0x3109058d147fdcddull },
+	{ 0xaa51823e34a7eedeull, 0xbd4b46f0599fd415ull },
+	{ 0xd4e5e2cdc1d1ea96ull, 0x6c9e18ac7007c91aull },
+	{ 0x850fadc09923329eull, 0x03e2cf6bc604ddb0ull },
+	{ 0xa6539930bf6bff45ull, 0x84db8346b786151cull },
+	{ 0xcfe87f7cef46ff16ull, 0xe612641865679a63ull },
+	{ 0x81f14fae158c5f6eull, 0x4fcb7e8f3f60c07eull },
+	{ 0xa26da3999aef7749ull, 0xe3be5e330f38f09dull },
+	{ 0xcb090c8001ab551cull, 0x5cadf5bfd3072cc5ull },
+	{ 0xfdcb4fa002162a63ull, 0x73d9732fc7c8f7f6ull },
+	{ 0x9e9f11c4014dda7eull, 0x2867e7fddcdd9afaull },
+	{ 0xc646d63501a1511dull, 0xb281e1fd541501b8ull },
+	{ 0xf7d88bc24209a565ull, 0x1f225a7ca91a4226ull },
+	{ 0x9ae757596946075full, 0x3375788de9b06958ull },
+	{ 0xc1a12d2fc3978937ull, 0x0052d6b1641c83aeull },
+	{ 0xf209787bb47d6b84ull, 0xc0678c5dbd23a49aull },
+	{ 0x9745eb4d50ce6332ull, 0xf840b7ba963646e0ull },
+	{ 0xbd176620a501fbffull, 0xb650e5a93bc3d898ull },
+	{ 0xec5d3fa8ce427affull, 0xa3e51f138ab4cebeull },
+	{ 0x93ba47c980e98cdfull, 0xc66f336c36b10137ull },
+	{ 0xb8a8d9bbe123f017ull, 0xb80b0047445d4184ull },
+	{ 0xe6d3102ad96cec1dull, 0xa60dc059157491e5ull },
+	{ 0x9043ea1ac7e41392ull, 0x87c89837ad68db2full },
+	{ 0xb454e4a179dd1877ull, 0x29babe4598c311fbull },
+	{ 0xe16a1dc9d8545e94ull, 0xf4296dd6fef3d67aull },
+	{ 0x8ce2529e2734bb1dull, 0x1899e4a65f58660cull },
+	{ 0xb01ae745b101e9e4ull, 0x5ec05dcff72e7f8full },
+	{ 0xdc21a1171d42645dull, 0x76707543f4fa1f73ull },
+	{ 0x899504ae72497ebaull, 0x6a06494a791c53a8ull },
+	{ 0xabfa45da0edbde69ull, 0x0487db9d17636892ull },
+	{ 0xd6f8d7509292d603ull, 0x45a9d2845d3c42b6ull },
+	{ 0x865b86925b9bc5c2ull, 0x0b8a2392ba45a9b2ull },
+	{ 0xa7f26836f282b732ull, 0x8e6cac7768d7141eull },
+	{ 0xd1ef0244af2364ffull, 0x3207d795430cd926ull },
+	{ 0x8335616aed761f1full, 0x7f44e6bd49e807b8ull },
+	{ 0xa402b9c5a8d3a6e7ull, 0x5f16206c9c6209a6ull },
+	{ 0xcd036837130890a1ull, 0x36dba887c37a8c0full },
+	{ 0x802221226be55a64ull, 0xc2494954da2c9789ull },
+	{ 0xa02aa96b06deb0fdull, 0xf2db9baa10b7bd6cull },
+	{ 0xc83553c5c8965d3dull, 0x6f92829494e5acc7ull },
+	{ 0xfa42a8b73abbf48cull, 0xcb772339ba1f17f9ull },
+	{ 0x9c69a97284b578d7ull, 0xff2a760414536efbull },
+	{ 0xc38413cf25e2d70dull, 0xfef5138519684abaull },
+	{ 0xf46518c2ef5b8cd1ull, 0x7eb258665fc25d69ull },
+	{ 0x98bf2f79d5993802ull, 0xef2f773ffbd97a61ull },
+	{ 0xbeeefb584aff8603ull, 0xaafb550ffacfd8faull },
+	{ 0xeeaaba2e5dbf6784ull, 0x95ba2a53f983cf38ull },
+	{ 0x952ab45cfa97a0b2ull, 0xdd945a747bf26183ull },
+	{ 0xba756174393d88dfull, 0x94f971119aeef9e4ull },
+	{ 0xe912b9d1478ceb17ull, 0x7a37cd5601aab85dull },
+	{ 0x91abb422ccb812eeull, 0xac62e055c10ab33aull },
+	{ 0xb616a12b7fe617aaull, 0x577b986b314d6009ull },
+	{ 0xe39c49765fdf9d94ull, 0xed5a7e85fda0b80bull },
+	{ 0x8e41ade9fbebc27dull, 0x14588f13be847307ull },
+	{ 0xb1d219647ae6b31cull, 0x596eb2d8ae258fc8ull },
+	{ 0xde469fbd99a05fe3ull, 0x6fca5f8ed9aef3bbull },
+	{ 0x8aec23d680043beeull, 0x25de7bb9480d5854ull },
+	{ 0xada72ccc20054ae9ull, 0xaf561aa79a10ae6aull },
+	{ 0xd910f7ff28069da4ull, 0x1b2ba1518094da04ull },
+	{ 0x87aa9aff79042286ull, 0x90fb44d2f05d0842ull },
+	{ 0xa99541bf57452b28ull, 0x353a1607ac744a53ull },
+	{ 0xd3fa922f2d1675f2ull, 0x42889b8997915ce8ull },
+	{ 0x847c9b5d7c2e09b7ull, 0x69956135febada11ull },
+	{ 0xa59bc234db398c25ull, 0x43fab9837e699095ull },
+	{ 0xcf02b2c21207ef2eull, 0x94f967e45e03f4bbull },
+	{ 0x8161afb94b44f57dull, 0x1d1be0eebac278f5ull },
+	{ 0xa1ba1ba79e1632dcull, 0x6462d92a69731732ull },
+	{ 0xca28a291859bbf93ull, 0x7d7b8f7503cfdcfeull },
+	{ 0xfcb2cb35e702af78ull, 0x5cda735244c3d43eull },
+	{ 0x9defbf01b061adabull, 0x3a0888136afa64a7ull },
+	{ 0xc56baec21c7a1916ull, 0x088aaa1845b8fdd0ull },
+	{ 0xf6c69a72a3989f5bull, 0x8aad549e57273d45ull },
+	{ 0x9a3c2087a63f6399ull, 0x36ac54e2f678864bull },
+	{ 0xc0cb28a98fcf3c7full, 0x84576a1bb416a7ddull },
+	{ 0xf0fdf2d3f3c30b9full, 0x656d44a2a11c51d5ull },
+	{ 0x969eb7c47859e743ull, 0x9f644ae5a4b1b325ull },
+	{ 0xbc4665b596706114ull, 0x873d5d9f0dde1feeull },
+	{ 0xeb57ff22fc0c7959ull, 0xa90cb506d155a7eaull },
+	{ 0x9316ff75dd87cbd8ull, 0x09a7f12442d588f2ull },
+	{ 0xb7dcbf5354e9beceull, 0x0c11ed6d538aeb2full },
+	{ 0xe5d3ef282a242e81ull, 0x8f1668c8a86da5faull },
+	{ 0x8fa475791a569d10ull, 0xf96e017d694487bcull },
+	{ 0xb38d92d760ec4455ull, 0x37c981dcc395a9acull },
+	{ 0xe070f78d3927556aull, 0x85bbe253f47b1417ull },
+	{ 0x8c469ab843b89562ull, 0x93956d7478ccec8eull },
+	{ 0xaf58416654a6babbull, 0x387ac8d1970027b2ull },
+	{ 0xdb2e51bfe9d0696aull, 0x06997b05fcc0319eull },
+	{ 0x88fcf317f22241e2ull, 0x441fece3bdf81f03ull },
+	{ 0xab3c2fddeeaad25aull, 0xd527e81cad7626c3ull },
+	{ 0xd60b3bd56a5586f1ull, 0x8a71e223d8d3b074ull },
+	{ 0x85c7056562757456ull, 0xf6872d5667844e49ull },
+	{ 0xa738c6bebb12d16cull, 0xb428f8ac016561dbull },
+	{ 0xd106f86e69d785c7ull, 0xe13336d701beba52ull },
+	{ 0x82a45b450226b39cull, 0xecc0024661173473ull },
+	{ 0xa34d721642b06084ull, 0x27f002d7f95d0190ull },
+	{ 0xcc20ce9bd35c78a5ull, 0x31ec038df7b441f4ull },
+	{ 0xff290242c83396ceull, 0x7e67047175a15271ull },
+	{ 0x9f79a169bd203e41ull, 0x0f0062c6e984d386ull },
+	{ 0xc75809c42c684dd1ull, 0x52c07b78a3e60868ull },
+	{ 0xf92e0c3537826145ull, 0xa7709a56ccdf8a82ull },
+	{ 0x9bbcc7a142b17ccbull, 0x88a66076400bb691ull },
+	{ 0xc2abf989935ddbfeull, 0x6acff893d00ea435ull },
+	{ 0xf356f7ebf83552feull, 0x0583f6b8c4124d43ull },
+	{ 0x98165af37b2153deull, 0xc3727a337a8b704aull },
+	{ 0xbe1bf1b059e9a8d6ull, 0x744f18c0592e4c5cull },
+	{ 0xeda2ee1c7064130cull, 0x1162def06f79df73ull },
+	{ 0x9485d4d1c63e8be7ull, 0x8addcb5645ac2ba8ull },
+	{ 0xb9a74a0637ce2ee1ull, 0x6d953e2bd7173692ull },
+	{ 0xe8111c87c5c1ba99ull, 0xc8fa8db6ccdd0437ull },
+	{ 0x910ab1d4db9914a0ull, 0x1d9c9892400a22a2ull },
+	{ 0xb54d5e4a127f59c8ull, 0x2503beb6d00cab4bull },
+	{ 0xe2a0b5dc971f303aull, 0x2e44ae64840fd61dull },
+	{ 0x8da471a9de737e24ull, 0x5ceaecfed289e5d2ull },
+	{ 0xb10d8e1456105dadull, 0x7425a83e872c5f47ull },
+	{ 0xdd50f1996b947518ull, 0xd12f124e28f77719ull },
+	{ 0x8a5296ffe33cc92full, 0x82bd6b70d99aaa6full },
+	{ 0xace73cbfdc0bfb7bull, 0x636cc64d1001550bull },
+	{ 0xd8210befd30efa5aull, 0x3c47f7e05401aa4eull },
+	{ 0x8714a775e3e95c78ull, 0x65acfaec34810a71ull },
+	{ 0xa8d9d1535ce3b396ull, 0x7f1839a741a14d0dull },
+	{ 0xd31045a8341ca07cull, 0x1ede48111209a050ull },
+	{ 0x83ea2b892091e44dull, 0x934aed0aab460432ull },
+	{ 0xa4e4b66b68b65d60ull, 0xf81da84d5617853full },
+	{ 0xce1de40642e3f4b9ull, 0x36251260ab9d668eull },
+	{ 0x80d2ae83e9ce78f3ull, 0xc1d72b7c6b426019ull },
+	{ 0xa1075a24e4421730ull, 0xb24cf65b8612f81full },
+	{ 0xc94930ae1d529cfcull, 0xdee033f26797b627ull },
+	{ 0xfb9b7cd9a4a7443cull, 0x169840ef017da3b1ull },
+	{ 0x9d412e0806e88aa5ull, 0x8e1f289560ee864eull },
+	{ 0xc491798a08a2ad4eull, 0xf1a6f2bab92a27e2ull },
+	{ 0xf5b5d7ec8acb58a2ull, 0xae10af696774b1dbull },
+	{ 0x9991a6f3d6bf1765ull, 0xacca6da1e0a8ef29ull },
+	{ 0xbff610b0cc6edd3full, 0x17fd090a58d32af3ull },
+	{ 0xeff394dcff8a948eull, 0xddfc4b4cef07f5b0ull },
+	{ 0x95f83d0a1fb69cd9ull, 0x4abdaf101564f98eull },
+	{ 0xbb764c4ca7a4440full, 0x9d6d1ad41abe37f1ull },
+	{ 0xea53df5fd18d5513ull, 0x84c86189216dc5edull },
+	{ 0x92746b9be2f8552cull, 0x32fd3cf5b4e49bb4ull },
+	{ 0xb7118682dbb66a77ull, 0x3fbc8c33221dc2a1ull },
+	{ 0xe4d5e82392a40515ull, 0x0fabaf3feaa5334aull },
+	{ 0x8f05b1163ba6832dull, 0x29cb4d87f2a7400eull },
+	{ 0xb2c71d5bca9023f8ull, 0x743e20e9ef511012ull },
+	{ 0xdf78e4b2bd342cf6ull, 0x914da9246b255416ull },
+	{ 0x8bab8eefb6409c1aull, 0x1ad089b6c2f7548eull },
+	{ 0xae9672aba3d0c320ull, 0xa184ac2473b529b1ull },
+	{ 0xda3c0f568cc4f3e8ull, 0xc9e5d72d90a2741eull },
+	{ 0x8865899617fb1871ull, 0x7e2fa67c7a658892ull },
+	{ 0xaa7eebfb9df9de8dull, 0xddbb901b98feeab7ull },
+	{ 0xd51ea6fa85785631ull, 0x552a74227f3ea565ull },
+	{ 0x8533285c936b35deull, 0xd53a88958f87275full },
+	{ 0xa67ff273b8460356ull, 0x8a892abaf368f137ull },
+	{ 0xd01fef10a657842cull, 0x2d2b7569b0432d85ull },
+	{ 0x8213f56a67f6b29bull, 0x9c3b29620e29fc73ull },
+	{ 0xa298f2c501f45f42ull, 0x8349f3ba91b47b8full },
+	{ 0xcb3f2f7642717713ull, 0x241c70a936219a73ull },
+	{ 0xfe0efb53d30dd4d7ull, 0xed238cd383aa0110ull },
+	{ 0x9ec95d1463e8a506ull, 0xf4363804324a40aaull },
+	{ 0xc67bb4597ce2ce48ull, 0xb143c6053edcd0d5ull },
+	{ 0xf81aa16fdc1b81daull, 0xdd94b7868e94050aull },
+	{ 0x9b10a4e5e9913128ull, 0xca7cf2b4191c8326ull },
+	{ 0xc1d4ce1f63f57d72ull, 0xfd1c2f611f63a3f0ull },
+	{ 0xf24a01a73cf2dccfull, 0xbc633b39673c8cecull },
+	{ 0x976e41088617ca01ull, 0xd5be0503e085d813ull },
+	{ 0xbd49d14aa79dbc82ull, 0x4b2d8644d8a74e18ull },
+	{ 0xec9c459d51852ba2ull, 0xddf8e7d60ed1219eull },
+	{ 0x93e1ab8252f33b45ull, 0xcabb90e5c942b503ull },
+	{ 0xb8da1662e7b00a17ull, 0x3d6a751f3b936243ull },
+	{ 0xe7109bfba19c0c9dull, 0x0cc512670a783ad4ull },
+	{ 0x906a617d450187e2ull, 0x27fb2b80668b24c5ull },
+	{ 0xb484f9dc9641e9daull, 0xb1f9f660802dedf6ull },
+	{ 0xe1a63853bbd26451ull, 0x5e7873f8a0396973ull },
+	{ 0x8d07e33455637eb2ull, 0xdb0b487b6423e1e8ull },
+	{ 0xb049dc016abc5e5full, 0x91ce1a9a3d2cda62ull },
+	{ 0xdc5c5301c56b75f7ull, 0x7641a140cc7810fbull },
+	{ 0x89b9b3e11b6329baull, 0xa9e904c87fcb0a9dull },
+	{ 0xac2820d9623bf429ull, 0x546345fa9fbdcd44ull },
+	{ 0xd732290fbacaf133ull, 0xa97c177947ad4095ull },
+	{ 0x867f59a9d4bed6c0ull, 0x49ed8eabcccc485dull },
+	{ 0xa81f301449ee8c70ull, 0x5c68f256bfff5a74ull },
+	{ 0xd226fc195c6a2f8cull, 0x73832eec6fff3111ull },
+	{ 0x83585d8fd9c25db7ull, 0xc831fd53c5ff7eabull },
+	{ 0xa42e74f3d032f525ull, 0xba3e7ca8b77f5e55ull },
+	{ 0xcd3a1230c43fb26full, 0x28ce1bd2e55f35ebull },
+	{ 0x80444b5e7aa7cf85ull, 0x7980d163cf5b81b3ull },
+	{ 0xa0555e361951c366ull, 0xd7e105bcc332621full },
+	{ 0xc86ab5c39fa63440ull, 0x8dd9472bf3fefaa7ull },
+	{ 0xfa856334878fc150ull, 0xb14f98f6f0feb951ull },
+	{ 0x9c935e00d4b9d8d2ull, 0x6ed1bf9a569f33d3ull },
+	{ 0xc3b8358109e84f07ull, 0x0a862f80ec4700c8ull },
+	{ 0xf4a642e14c6262c8ull, 0xcd27bb612758c0faull },
+	{ 0x98e7e9cccfbd7dbdull, 0x8038d51cb897789cull },
+	{ 0xbf21e44003acdd2cull, 0xe0470a63e6bd56c3ull },
+	{ 0xeeea5d5004981478ull, 0x1858ccfce06cac74ull },
+	{ 0x95527a5202df0ccbull, 0x0f37801e0c43ebc8ull },
+	{ 0xbaa718e68396cffdull, 0xd30560258f54e6baull },
+	{ 0xe950df20247c83fdull, 0x47c6b82ef32a2069ull },
+	{ 0x91d28b7416cdd27eull, 0x4cdc331d57fa5441ull },
+	{ 0xb6472e511c81471dull, 0xe0133fe4adf8e952ull },
+	{ 0xe3d8f9e563a198e5ull, 0x58180fddd97723a6ull },
+	{ 0x8e679c2f5e44ff8full, 0x570f09eaa7ea7648ull }
+};
+
+static const double EXACT_POW10[] = {
+	1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+typedef struct { uint64_t hi, lo; } uint128_parts;
+
+static uint128_parts uint64_mult_full(uint64_t a, uint64_t b)
+{
+#if defined(__SIZEOF_INT128__)
+	unsigned __int128 r = (unsigned __int128)a * b;
+	return (uint128_parts){ r >> 64, (uint64_t)r };
+#else
+	const uint64_t M32 = 0xFFFFFFFFu;
+	uint64_t ah = a >> 32, al = a & M32, bh = b >> 32, bl = b & M32;
+	uint64_t ll = al * bl, lh = al * bh, hl = ah * bl, hh = ah * bh;
+	uint64_t mid = (ll >> 32) + (lh & M32) + (hl & M32);
+	return (uint128_parts){ hh + (lh >> 32) + (hl >> 32) + (mid >> 32), (mid << 32) | (ll & M32) };
+#endif
 }
 
-void *Chain_foreach(Chain *chain, void (*fn)(void*,void*), void *baggage, int offset)
+// Compute w * 10^q correctly rounded. Returns false for the rare inputs
+// that need more precision, or a subnormal result.
+static bool eisel_lemire(uint64_t w, int q, bool negative, double *d)
 {
-	for (struct link *n = chain->head.next; n && n != &chain->head; n = n->next)
-		fn(baggage, (byte*)n + offset);
-	return baggage;
+	if (-22 <= q && q <= 22 && w <= (1ull << 53)) {
+		*d = (q < 0) ? (double)w / EXACT_POW10[-q] : (double)w * EXACT_POW10[q];
+		*d = negative ? -*d : *d;
+		return true;
+	}
+
+	if (w == 0 || q < POW5_MIN_EXP - 19) {
+		*d = negative ? -0.0 : 0.0;
+		return true;
+	}
+	if (q > POW5_MAX_EXP) {
+		*d = negative ? -INFINITY : INFINITY;
+		return true;
+	}
+	if (q < POW5_MIN_EXP)
+		return false;
+
+	const uint64_t *pow5 = POW5_128[q - POW5_MIN_EXP];
+	int64_t exponent = (((152170 + 65536) * (int64_t)q) >> 16) + 1024 + 63;
+	int lz = uint64_leading_zeros(w);
+	w <<= lz;
+
+	uint128_parts product = uint64_mult_full(w, pow5[0]);
+	uint64_t upper = product.hi, lower = product.lo;
+
+	if ((upper & 0x1FF) == 0x1FF && lower + w < lower) {
+		uint128_parts low = uint64_mult_full(w, pow5[1]);
+		uint64_t middle = lower + low.hi;
+		if (middle < lower)
+			++upper;
+		if (middle + 1 == 0 && (upper & 0x1FF) == 0x1FF && low.lo + w < low.lo)
+			return false;
+		lower = middle;
+	}
+
+	uint64_t upper_bit = upper >> 63;
+	uint64_t mantissa  = upper >> (upper_bit + 9);
+	lz += 1 ^ upper_bit;
+
+	// Exactly halfway between two doubles: let the fallback decide.
+	if (lower == 0 && (upper & 0x1FF) == 0 && (mantissa & 3) == 1)
+		return false;
+
+	mantissa += mantissa & 1;
+	mantissa >>= 1;
+	if (mantissa >= (1ull << 53)) {
+		mantissa = 1ull << 52;
+		--lz;
+	}
+	mantissa &= ~(1ull << 52);
+
+	int64_t biased = exponent - lz;
+	if (biased < 1 || biased > 2046)
+		return false;
+
+	uint64_t bits = mantissa | (uint64_t)biased << 52 | (uint64_t)negative << 63;
+	memcpy(d, &bits, sizeof(*d));
+	return true;
 }
 
+// Exact decimal to double conversion for the inputs Eisel-Lemire leaves
+// undecided, after Nigel Tao's simple decimal conversion in Go's strconv.
+// The number is held as decimal digits and scaled by powers of two until
+// it lies in [1/2, 1), then its top 53 bits are read off with correct
+// rounding. 800 digits are enough to decide every halfway case; any
+// digits beyond are only remembered as nonzero.
 
-//----------------------------------------------------------------------
-//@module Logging
-//
+enum { DECIMAL_DIGITS = 800, DECIMAL_MAX_SHIFT = 60 };
 
-char *timestamp(char *s, size_t num, struct tm *(*totime)(const time_t*))
+struct decimal
 {
-	time_t now = time(NULL);
-	strftime(s, num, "%Y-%m-%d %H.%M.%S %Z", totime(&now));
-	return s;
+	uint8_t  d[DECIMAL_DIGITS + 20];  // room for a left shift to spill
+	int      nd, dp;                  // digit count, decimal point position
+	bool     trunc;                   // nonzero digits were dropped
+};
+
+static void decimal_trim(struct decimal *a)
+{
+	while (a->nd > 0 && a->d[a->nd - 1] == 0)
+		--a->nd;
+	if (a->nd == 0)
+		a->dp = 0;
 }
 
+// Parse the digits, point and exponent already validated by parse_double.
+static void decimal_set(struct decimal *a, const char *p, const char *end)
+{
+	*a = (struct decimal){0};
+	bool saw_dot = false;
 
+	for (; p < end && (isdigit((unsigned char)*p) || *p == '.'); ++p) {
+		if (*p == '.') {
+			saw_dot = true;
+			a->dp = a->nd;
+			continue;
+		}
+		if (*p == '0' && a->nd == 0) {
+			--a->dp;
+			continue;
+		}
+		if (a->nd < DECIMAL_DIGITS)
+			a->d[a->nd++] = *p - '0';
+		else if (*p != '0')
+			a->trunc = true;
+	}
+	if (!saw_dot)
+		a->dp = a->nd;
 
+	if (p < end && (*p == 'e' || *p == 'E')) {
+		++p;
+		bool negative = (p < end && *p == '-');
+		if (p < end && (*p == '-' || *p == '+'))
+			++p;
+		int e = 0;
+		for (; p < end && isdigit((unsigned char)*p); ++p)
+			if (e < 100000)  e = e * 10 + (*p - '0');
+		a->dp += negative ? -e : e;
+	}
+	decimal_trim(a);
+}
 
+static void decimal_right_shift(struct decimal *a, int k)
+{
+	int r = 0, w = 0;
+	uint64_t n = 0;
 
+	for (; (n >> k) == 0; ++r) {
+		if (r >= a->nd) {
+			if (n == 0) {
+				a->nd = 0;
+				return;
+			}
+			for (; (n >> k) == 0; ++r)
+				n *= 10;
+			break;
+		}
+		n = n * 10 + a->d[r];
+	}
+	a->dp -= r - 1;
 
-#define X(A,B,C)  {A,B,C},
-static const int XORSHIFT_PARAM_LIST[][3] = {
-	XORSHIFT_PARAMS
-};
-#undef X
+	uint64_t mask = (1ull << k) - 1;
+	for (; r < a->nd; ++r) {
+		a->d[w++] = n >> k;
+		n = (n & mask) * 10 + a->d[r];
+	}
+	for (; n > 0; n = (n & mask) * 10) {
+		if (w < DECIMAL_DIGITS)
+			a->d[w++] = n >> k;
+		else if (n >> k)
+			a->trunc = true;
+	}
 
-void Xorshift_init(Xorshifter *state, uint32_t seed, int params_num)
+	a->nd = w;
+	decimal_trim(a);
+}
+
+static void decimal_left_shift(struct decimal *a, int k)
 {
-	params_num = params_num % ARRAY_SIZE(XORSHIFT_PARAM_LIST);
-    const int *params = XORSHIFT_PARAM_LIST[params_num];
+	// 2^k has at most k * log10(2) + 1 digits; write the product right
+	// aligned past the old digits, then slide it down.
+	int top = a->nd + (k * 78) / 256 + 1;
+	int w = top;
+	uint64_t n = 0;
 
-    *state = (Xorshifter)
-    { 
-        .a = params[0], 
-        .b = params[1], 
-        .c = params[2], 
-        .x = seed
-    };
+	for (int r = a->nd - 1; r >= 0; --r) {
+		n += (uint64_t)a->d[r] << k;
+		a->d[--w] = n % 10;
+		n /= 10;
+	}
+	for (; n > 0; n /= 10)
+		a->d[--w] = n % 10;
+
+	int nd = top - w;
+	memmove(a->d, a->d + w, nd);
+	a->dp += nd - a->nd;
+
+	if (nd > DECIMAL_DIGITS) {
+		for (int i = DECIMAL_DIGITS; i < nd; ++i)
+			a->trunc |= a->d[i] != 0;
+		nd = DECIMAL_DIGITS;
+	}
+	a->nd = nd;
+	decimal_trim(a);
 }
 
-uint32_t Xorshift_rand(Xorshifter *state)
+// Multiply by 2^k, or divide for negative k.
+static void decimal_shift(struct decimal *a, int k)
 {
-	uint32_t x = state->x;
-	x ^= x << state->a;
-	x ^= x >> state->b;
-	x ^= x << state->c;
-	return state->x = x;
+	if (a->nd == 0)
+		return;
+	for (; k > DECIMAL_MAX_SHIFT; k -= DECIMAL_MAX_SHIFT)
+		decimal_left_shift(a, DECIMAL_MAX_SHIFT);
+	for (; k < -DECIMAL_MAX_SHIFT; k += DECIMAL_MAX_SHIFT)
+		decimal_right_shift(a, DECIMAL_MAX_SHIFT);
+	if (k > 0)
+		decimal_left_shift(a, k);
+	else if (k < 0)
+		decimal_right_shift(a, -k);
 }
 
-uint64_t hash_fnv_1a_64bit(struct byte_span data, uint64_t hash)
+// Whether rounding to nd digits rounds up, ties to even.
+static bool decimal_round_up(const struct decimal *a, int nd)
 {
-	const uint64_t fnv_1a_64bit_prime = 0x100000001B3;
+	if (nd < 0 || nd >= a->nd)
+		return false;
+	if (a->d[nd] == 5 && nd + 1 == a->nd)
+		return a->trunc || (nd > 0 && a->d[nd - 1] % 2);
+	return a->d[nd] >= 5;
+}
 
-	const byte *end = data.back;
-	for (const byte *b = data.front; b != end; ++b) {
-		hash ^= (uint64_t)*b;
-		hash *= fnv_1a_64bit_prime;
+static uint64_t decimal_rounded_integer(const struct decimal *a)
+{
+	uint64_t n = 0;
+	int i = 0;
+	for (; i < a->dp && i < a->nd; ++i)
+		n = n * 10 + a->d[i];
+	for (; i < a->dp; ++i)
+		n *= 10;
+	return n + decimal_round_up(a, a->dp);
+}
+
+enum { DOUBLE_MANT_BITS = 52, DOUBLE_BIAS = -1023 };
+
+#define DOUBLE_INF_BITS  (0x7FFull << DOUBLE_MANT_BITS)
+
+// The bits of the nearest double, without the sign.
+static uint64_t decimal_double_bits(struct decimal *a)
+{
+	// Binary digits of 10^n, to scale by about n decimal places at a time.
+	static const int POWERS[] = { 1, 3, 6, 9, 13, 16, 19, 23, 26 };
+	const int powers_count = ARRAY_SIZE(POWERS);
+
+	if (a->nd == 0 || a->dp < -330)
+		return 0;
+	if (a->dp > 310)
+		return DOUBLE_INF_BITS;
+
+	int exp = 0;
+	while (a->dp > 0) {
+		int n = (a->dp >= powers_count) ? 27 : POWERS[a->dp];
+		decimal_shift(a, -n);
+		exp += n;
+	}
+	while (a->dp < 0 || (a->dp == 0 && a->d[0] < 5)) {
+		int n = (-a->dp >= powers_count) ? 27 : POWERS[-a->dp];
+		decimal_shift(a, n);
+		exp -= n;
 	}
 
-	return hash;
+	// Now in [1/2, 1); doubles are in [1, 2).
+	--exp;
+	if (exp < DOUBLE_BIAS + 1) {
+		decimal_shift(a, exp - (DOUBLE_BIAS + 1));
+		exp = DOUBLE_BIAS + 1;
+	}
+	if (exp - DOUBLE_BIAS >= 2047)
+		return DOUBLE_INF_BITS;
+
+	decimal_shift(a, 1 + DOUBLE_MANT_BITS);
+	uint64_t mantissa = decimal_rounded_integer(a);
+	if (mantissa == 2ull << DOUBLE_MANT_BITS) {
+		mantissa >>= 1;
+		if (++exp - DOUBLE_BIAS >= 2047)
+			return DOUBLE_INF_BITS;
+	}
+	if (!(mantissa & (1ull << DOUBLE_MANT_BITS)))
+		exp = DOUBLE_BIAS;  // subnormal
+
+	return (mantissa & ((1ull << DOUBLE_MANT_BITS) - 1)) | (uint64_t)(exp - DOUBLE_BIAS) << DOUBLE_MANT_BITS;
+}
+
+static double decimal_to_double(struct decimal *a, bool negative)
+{
+	uint64_t bits = decimal_double_bits(a) | (uint64_t)negative << 63;
+	double d;
+	memcpy(&d, &bits, sizeof(d));
+	return d;
+}
+
+static bool strand_starts_with_nocase(struct strand s, const char *word)
+{
+	int n = strlen(word);
+	return strand_length(s) >= n && strand_equals_nocase(strand_init_n(s.front, n), strand_init_n(word, n));
+}
+
+enum status parse_double(struct strand s, double *value, int *used)
+{
+	const char *p = s.front, *end = s.back;
+	bool negative = (p < end && *p == '-');
+	if (p < end && (*p == '-' || *p == '+'))
+		++p;
+
+	struct strand rest = { p, end };
+	if (strand_starts_with_nocase(rest, "inf") || strand_starts_with_nocase(rest, "nan")) {
+		bool inf = (tolower((unsigned char)*p) == 'i');
+		p += strand_starts_with_nocase(rest, "infinity") ? 8 : 3;
+		*value = inf ? INFINITY : NAN;
+		*value = negative ? -*value : *value;
+		if (used)  *used = p - s.front;
+		return STATUS_OK;
+	}
+
+	uint64_t w = 0;
+	int digits = 0, exp10 = 0;
+	bool any_digits = false;
+
+	for (; p < end && *p == '0'; ++p)
+		any_digits = true;
+	for (; p < end && isdigit((unsigned char)*p); ++p, any_digits = true) {
+		if (digits++ < 19)  w = w * 10 + (*p - '0');
+		else                ++exp10;
+	}
+
+	if (p < end && *p == '.') {
+		++p;
+		if (digits == 0)
+			for (; p < end && *p == '0'; ++p, --exp10)
+				any_digits = true;
+		for (; p < end && isdigit((unsigned char)*p); ++p, any_digits = true) {
+			if (digits++ < 19)  w = w * 10 + (*p - '0'), --exp10;
+		}
+	}
+
+	if (!any_digits) {
+		if (used)  *used = 0;
+		return STATUS_ERROR;
+	}
+
+	if (p < end && (*p == 'e' || *p == 'E')) {
+		const char *e = p + 1;
+		bool exp_negative = (e < end && *e == '-');
+		if (e < end && (*e == '-' || *e == '+'))
+			++e;
+		if (e < end && isdigit((unsigned char)*e)) {
+			int n = 0;
+			for (; e < end && isdigit((unsigned char)*e); ++e)
+				if (n < 100000)  n = n * 10 + (*e - '0');
+			exp10 += exp_negative ? -n : n;
+			p = e;
+		}
+	}
+
+	if (used)  *used = p - s.front;
+
+	// More than 19 significant digits, or a case Eisel-Lemire can't
+	// settle: convert the digits exactly.
+	if (digits > 19 || !eisel_lemire(w, exp10, negative, value)) {
+		struct decimal dec;
+		decimal_set(&dec, s.front + (negative || *s.front == '+'), p);
+		*value = decimal_to_double(&dec, negative);
+	}
+
+	return isinf(*value) ? STATUS_MATH_OVERFLOW : STATUS_OK;
+}
+
+//----------------------------------------------------------------------
+// writer Module
+
+// Write every byte described by iov, retrying short writes and EINTR.
+static enum status writev_all(int fd, struct iovec *iov, int count)
+{
+	while (count > 0) {
+		ssize_t n = writev(fd, iov, count);
+		if (n < 0) {
+			if (errno == EINTR)  continue;
+			return STATUS_IO_FAILURE;
+		}
+
+		for (; count > 0 && (size_t)n >= iov->iov_len; ++iov, --count)
+			n -= iov->iov_len;
+
+		if (count > 0) {
+			iov->iov_base = (byte*)iov->iov_base + n;
+			iov->iov_len -= n;
+		}
+	}
+	return STATUS_OK;
+}
+
+enum status writer_flush(writer *w)
+{
+	if (w->status != STATUS_OK || strbuf_length(&w->buf) == 0)
+		return w->status;
+
+	struct iovec iov = { w->buf.front, strbuf_length(&w->buf) };
+	w->status = writev_all(w->fd, &iov, 1);
+	if (w->status == STATUS_OK)
+		w->buf.back = w->buf.front;
+
+	return w->status;
+}
+
+enum status writer_write(writer *w, const void *data, size_t n)
+{
+	if (w->status != STATUS_OK)
+		return w->status;
+
+	if (n > (size_t)strbuf_cap(&w->buf)) {
+		// Too big to ever buffer: send buffered bytes and data together.
+		if (n >= w->buf.size) {
+			struct iovec iov[] = {
+				{ w->buf.front, strbuf_length(&w->buf) },
+				{ (void*)data, n }
+			};
+			w->status = writev_all(w->fd, iov, ARRAY_SIZE(iov));
+			if (w->status == STATUS_OK)
+				w->buf.back = w->buf.front;
+			return w->status;
+		}
+
+		if (writer_flush(w) != STATUS_OK)
+			return w->status;
+	}
+
+	memcpy(w->buf.back, data, n);
+	w->buf.back += n;
+	return STATUS_OK;
+}
+
+void writer_puts(writer *w, struct strand str)
+{
+	writer_write(w, str.front, strand_length(str));
+}
+
+void writer_put_String(writer *w, String s)
+{
+	writer_write(w, s.data, s.length);
+}
+
+void writer_put_int(writer *w, long long n)
+{
+	char digits[INT_STR_SIZE];
+	writer_write(w, digits, int64_to_str(digits, n));
+}
+
+void writer_put_uint(writer *w, unsigned long long n)
+{
+	char digits[INT_STR_SIZE];
+	writer_write(w, digits, uint64_to_str(digits, n));
+}
+
+void writer_put_double(writer *w, double d)
+{
+	char digits[DOUBLE_STR_SIZE];
+	writer_write(w, digits, double_to_str(digits, d));
+}
+
+bool strand_equals(struct strand a, struct strand b)
+{
+	if (strand_length(a) != strand_length(b))
+		return false;
+
+	return !strncmp(a.front, b.front, strand_length(a));
+}
+
+void strand_fputs(FILE *out, struct strand str)
+{
+	fprintf(out, "%.*s\n", strand_length(str), str.front);
+}
+
+struct strand strand_trim_back(struct strand s, int (*istype)(int))
+{
+	while (s.back > s.front && istype(*(s.back-1))) 
+		--s.back;
+	return s;
+}
+
+struct strand strand_trim_front(struct strand s, int (*istype)(int))
+{
+	while (s.front < s.back && istype(*s.front)) 
+		++s.front;
+	return s;
+}
+
+struct strand strand_trim(struct strand s, int (*istype)(int))
+{
+	return strand_trim_back( strand_trim_front(s, istype), istype);
+}
+
+#define ASCII_ONES   0x0101010101010101ull
+#define ASCII_HIGHS  0x8080808080808080ull
+
+// Set 0x20 in every byte of w that is an ASCII letter between lo and hi.
+static uint64_t ascii_case_bits(uint64_t w, char lo, char hi)
+{
+	uint64_t heptets = w & ~ASCII_HIGHS;
+	uint64_t ge_lo = heptets + (0x80 - lo) * ASCII_ONES;
+	uint64_t gt_hi = heptets + (0x80 - hi - 1) * ASCII_ONES;
+	return ((ge_lo ^ gt_hi) & ~w & ASCII_HIGHS) >> 2;
+}
+
+static uint64_t ascii_word_lower(uint64_t w)
+{
+	return w | ascii_case_bits(w, 'A', 'Z');
+}
+
+static uint64_t ascii_load(const char *p)
+{
+	uint64_t w;
+	memcpy(&w, p, sizeof(w));
+	return w;
+}
+
+static int ascii_lower(int c)
+{
+	return ('A' <= c && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+// Length of the common case-insensitive prefix of a and b, up to n.
+static int ascii_common_nocase(const char *a, const char *b, int n)
+{
+	int i = 0;
+	for (; n - i >= 8; i += 8)
+		if (ascii_word_lower(ascii_load(a + i)) != ascii_word_lower(ascii_load(b + i)))
+			break;
+	for (; i < n; ++i)
+		if (ascii_lower((unsigned char)a[i]) != ascii_lower((unsigned char)b[i]))
+			break;
+	return i;
+}
+
+bool strand_equals_nocase(struct strand a, struct strand b)
+{
+	int n = strand_length(a);
+	return n == strand_length(b) && ascii_common_nocase(a.front, b.front, n) == n;
+}
+
+int strand_compare_nocase(struct strand a, struct strand b)
+{
+	int na = strand_length(a), nb = strand_length(b);
+	int n = int_min(na, nb);
+	int i = ascii_common_nocase(a.front, b.front, n);
+
+	if (i < n)
+		return ascii_lower((unsigned char)a.front[i]) - ascii_lower((unsigned char)b.front[i]);
+
+	return (na > nb) - (na < nb);
+}
+
+void ascii_to_lower(char *s, int n)
+{
+	int i = 0;
+	for (; n - i >= 8; i += 8) {
+		uint64_t w = ascii_load(s + i);
+		w |= ascii_case_bits(w, 'A', 'Z');
+		memcpy(s + i, &w, sizeof(w));
+	}
+	for (; i < n; ++i)
+		s[i] = ascii_lower((unsigned char)s[i]);
+}
+
+void ascii_to_upper(char *s, int n)
+{
+	int i = 0;
+	for (; n - i >= 8; i += 8) {
+		uint64_t w = ascii_load(s + i);
+		w &= ~ascii_case_bits(w, 'a', 'z');
+		memcpy(s + i, &w, sizeof(w));
+	}
+	for (; i < n; ++i)
+		if ('a' <= s[i] && s[i] <= 'z')
+			s[i] -= 'a' - 'A';
+}
+
+strand_splitter strand_split_char(struct strand s, char sep)
+{
+	return (strand_splitter){ .rest = s, .by = SPLIT_CHAR, .done = strand_is_null(s), .sep_char = sep };
+}
+
+strand_splitter strand_split_any(struct strand s, struct strand seps)
+{
+	strand_splitter it = { .rest = s, .by = SPLIT_ANY, .done = strand_is_null(s) };
+	for (const char *c = seps.front; c != seps.back; ++c)
+		it.sep_set[(uint8_t)*c / 8] |= 1u << ((uint8_t)*c % 8);
+	return it;
+}
+
+strand_splitter strand_split_str(struct strand s, struct strand sep)
+{
+	REQUIRE(!strand_is_empty(sep));
+	return (strand_splitter){ .rest = s, .by = SPLIT_SUBSTR, .done = strand_is_null(s), .sep_str = sep };
+}
+
+// Find the next separator in s, returning its first char and setting
+// *sep_len, or NULL if there isn't one.
+static const char *strand_split_find(const strand_splitter *it, struct strand s, int *sep_len)
+{
+	*sep_len = 1;
+
+	switch (it->by) {
+		case SPLIT_CHAR:
+			return memchr(s.front, it->sep_char, strand_length(s));
+
+		case SPLIT_ANY:
+			for (const char *c = s.front; c != s.back; ++c)
+				if (it->sep_set[(uint8_t)*c / 8] & (1u << ((uint8_t)*c % 8)))
+					return c;
+			return NULL;
+
+		case SPLIT_SUBSTR: {
+			int n = strand_length(it->sep_str);
+			*sep_len = n;
+			if (strand_length(s) < n)
+				return NULL;
+			const char *last = s.back - n;
+			for (const char *c = s.front; c <= last; ++c) {
+				c = memchr(c, *it->sep_str.front, last - c + 1);
+				if (!c || !memcmp(c, it->sep_str.front, n))
+					return c;
+			}
+			return NULL;
+		}
+	}
+
+	return NULL;
+}
+
+bool strand_split_next(strand_splitter *it, struct strand *field)
+{
+	if (it->done)
+		return false;
+
+	int sep_len = 0;
+	const char *sep = strand_split_find(it, it->rest, &sep_len);
+
+	if (sep) {
+		*field = (struct strand){ it->rest.front, sep };
+		it->rest.front = sep + sep_len;
+	}
+	else {
+		*field = it->rest;
+		it->done = true;
+	}
+
+	return true;
+}
+
+
+
+
+struct byte_span Bytes_init_str(char *s)
+{
+	return (struct byte_span)byte_span_init_n((byte*)s, strlen(s));
+}
+
+
+
+#define LIST_MIN_CAPACITY 8
+
+static int list_growth_percent = 200;
+
+void List_set_growth(int percent)
+{
+	REQUIRE(percent >= 100);
+	list_growth_percent = percent;
+}
+
+static void *List_realloc(void *l, Size sizeof_base, Size sizeof_item, Size cap)
+{
+	size_t size = try_size_mult(sizeof_item, cap, NULL, CURRENT_LOCATION);
+	size = try_size_add(size, sizeof_base, NULL, CURRENT_LOCATION);
+	if (size > PTRDIFF_MAX)
+		except_throw(NULL, STATUS_MATH_OVERFLOW, CURRENT_LOCATION);
+
+	ListDims *b = realloc(l, size);
+	if (!b)
+		except_throw(NULL, STATUS_MALLOC_FAIL, CURRENT_LOCATION);
+
+	if (!l)  b->length = 0;
+	b->cap = cap;
+	return b;
+}
+
+void *List_grow(void *l, Size sizeof_base, Size sizeof_item, Size min_cap, Size add_length)
+{
+//	CHECK(min_cap || add_length);
+
+	ListDims *b = l;
+
+	Size new_length = try_size_add(List_length(l), add_length, NULL, CURRENT_LOCATION);
+	Size cap = (min_cap > new_length) ? min_cap : new_length;
+
+	if (List_capacity(l) < cap) {
+		// Explicit reserves are exact; growing to fit new items is not.
+		if (add_length > 0) {
+			Size grown = try_size_mult(List_capacity(l), list_growth_percent, NULL, CURRENT_LOCATION) / 100;
+			if (cap < grown)               cap = grown;
+			if (cap < LIST_MIN_CAPACITY)   cap = LIST_MIN_CAPACITY;
+		}
+		b = List_realloc(l, sizeof_base, sizeof_item, cap);
+	}
+
+	if (b)  b->length = new_length;
+
+	return b;
+}
+
+// storage holds local_cap elements inline or, once the capacity is
+// larger than that, a pointer to the heap copy.
+void SmallList_grow(ListDims *head, void *storage, Size local_cap, Size sizeof_item, Size min_cap, Size add_length)
+{
+	bool on_heap = head->cap > local_cap;
+	Size cap = on_heap ? head->cap : local_cap;
+	Size new_length = try_size_add(head->length, add_length, NULL, CURRENT_LOCATION);
+	Size needed = (min_cap > new_length) ? min_cap : new_length;
+
+	if (needed > cap) {
+		if (add_length > 0) {
+			Size grown = try_size_mult(cap, list_growth_percent, NULL, CURRENT_LOCATION) / 100;
+			if (needed < grown)  needed = grown;
+		}
+
+		size_t size = try_size_mult(sizeof_item, needed, NULL, CURRENT_LOCATION);
+		void *heap = on_heap ? realloc(*(void**)storage, size) : malloc(size);
+		if (!heap)
+			except_throw(NULL, STATUS_MALLOC_FAIL, CURRENT_LOCATION);
+
+		if (!on_heap)
+			memcpy(heap, storage, sizeof_item * head->length);
+		*(void**)storage = heap;
+		cap = needed;
+	}
+
+	head->cap = cap;
+	head->length = new_length;
+}
+
+void SmallList_append(ListDims *head, void *storage, Size local_cap, Size sizeof_item, const void *items, Size count)
+{
+	Size at = head->length;
+
+	// items may be the list's own elements, which growing can move from
+	// the heap or from local storage, so remember them by index.
+	uintptr_t front = (uintptr_t)((head->cap > local_cap) ? *(char**)storage : storage);
+	uintptr_t from = (uintptr_t)items;
+	bool own = count > 0 && front <= from && from < front + sizeof_item * at;
+	Size src = own ? (Size)(from - front) / sizeof_item : 0;
+
+	SmallList_grow(head, storage, local_cap, sizeof_item, 0, count);
+
+	char *grown = (head->cap > local_cap) ? *(char**)storage : storage;
+	if (own)
+		items = grown + sizeof_item * src;
+	if (count > 0)
+		memcpy(grown + sizeof_item * at, items, sizeof_item * count);
+}
+
+void *List_shrink(void *l, Size sizeof_base, Size sizeof_item)
+{
+	if (List_is_empty(l)) {
+		free(l);
+		return NULL;
+	}
+
+	if (List_capacity(l) == List_length(l))
+		return l;
+
+	return List_realloc(l, sizeof_base, sizeof_item, List_length(l));
+}
+
+void List_dispose(void *l)
+{
+	free(l);
+}
+
+void List_bounds_failure(Size i, Size length, SourceLine loc)
+{
+	char buf[100] = "";
+	snprintf(buf, sizeof(buf), "%td is out of bounds [0..%td)", i, length);
+	assert_failure(loc, DEBUG_LEVEL_MIN, buf);
+}
+
+static char *List_item(void *l, Size sizeof_base, Size sizeof_item, Size i)
+{
+	return (char*)l + sizeof_base + sizeof_item * i;
+}
+
+void *List_insert(void *l, Size sizeof_base, Size sizeof_item, Size at, const void *items, Size count)
+{
+	Size length = List_length(l);
+	REQUIRE(0 <= at  &&  at <= length  &&  count >= 0);
+
+	if (count == 0)
+		return l;
+
+	// items may be the list's own elements, which growing can move, so
+	// remember them by index. Those at or after `at` get shifted too.
+	uintptr_t front = l ? (uintptr_t)List_item(l, sizeof_base, sizeof_item, 0) : 0;
+	uintptr_t from = (uintptr_t)items;
+	bool own = l && front <= from && from < front + sizeof_item * length;
+	Size src = own ? (Size)(from - front) / sizeof_item : 0;
+
+	l = List_grow(l, sizeof_base, sizeof_item, 0, count);
+	memmove(List_item(l, sizeof_base, sizeof_item, at + count),
+	        List_item(l, sizeof_base, sizeof_item, at),
+	        sizeof_item * (length - at));
+
+	if (!own) {
+		memcpy(List_item(l, sizeof_base, sizeof_item, at), items, sizeof_item * count);
+		return l;
+	}
+
+	Size before = (src < at) ? ((at - src < count) ? at - src : count) : 0;
+	memcpy(List_item(l, sizeof_base, sizeof_item, at),
+	       List_item(l, sizeof_base, sizeof_item, src), sizeof_item * before);
+	memcpy(List_item(l, sizeof_base, sizeof_item, at + before),
+	       List_item(l, sizeof_base, sizeof_item, src + before + count), sizeof_item * (count - before));
+	return l;
+}
+
+void List_erase(void *l, Size sizeof_base, Size sizeof_item, Size at, Size count)
+{
+	Size length = List_length(l);
+	REQUIRE(0 <= at  &&  0 <= count  &&  count <= length - at);
+
+	if (count == 0)
+		return;
+
+	memmove(List_item(l, sizeof_base, sizeof_item, at),
+	        List_item(l, sizeof_base, sizeof_item, at + count),
+	        sizeof_item * (length - at - count));
+	LIST_BASE(l)->length -= count;
+}
+
+void List_swap_remove(void *l, Size sizeof_base, Size sizeof_item, Size i)
+{
+	Size last = List_length(l) - 1;
+	REQUIRE(0 <= i  &&  i <= last);
+
+	if (i != last)
+		memcpy(List_item(l, sizeof_base, sizeof_item, i),
+		       List_item(l, sizeof_base, sizeof_item, last),
+		       sizeof_item);
+	LIST_BASE(l)->length = last;
+}
+
+void *List_resize(void *l, Size sizeof_base, Size sizeof_item, Size length, bool zero_fill)
+{
+	Size old_length = List_length(l);
+	REQUIRE(length >= 0);
+
+	if (length <= old_length) {
+		if (l)  LIST_BASE(l)->length = length;
+		return l;
+	}
+
+	l = List_grow(l, sizeof_base, sizeof_item, 0, length - old_length);
+	if (zero_fill)
+		memset(List_item(l, sizeof_base, sizeof_item, old_length), 0, sizeof_item * (length - old_length));
+	return l;
+}
+
+
+
+void sum_ints(void *total, void *next_i)
+{
+	*(int*)total += *(int*)next_i;
+}
+
+
+
+//----------------------------------------------------------------------
+// slot_map Module
+
+static void *slot_map_item(const slot_map *m, Size i)
+{
+	return (Byte*)m->dense + sizeof(ListDims) + m->item_size * i;
+}
+
+slot_handle slot_map_insert(slot_map *m, const void *item)
+{
+	uint32_t index = m->free_slot;
+
+	if (index != SLOT_MAP_NONE)
+		m->free_slot = m->slots->front[index].dense;
+	else {
+		REQUIRE(List_length(m->slots) < SLOT_MAP_NONE);
+		index = List_length(m->slots);
+		LIST_PUSH(m->slots, ((struct slot_entry){ .generation = 1 }));
+	}
+
+	Size dense = slot_map_count(m);
+	m->dense = List_grow(m->dense, sizeof(ListDims), m->item_size, 0, 1);
+	memcpy(slot_map_item(m, dense), item, m->item_size);
+	LIST_PUSH(m->dense_slot, index);
+
+	struct slot_entry *slot = &m->slots->front[index];
+	slot->dense = dense;
+	return (slot_handle){ .index = index, .generation = slot->generation };
+}
+
+static struct slot_entry *slot_map_entry(const slot_map *m, slot_handle h)
+{
+	if (h.index >= List_length(m->slots))
+		return NULL;
+
+	struct slot_entry *slot = &m->slots->front[h.index];
+	return (slot->generation == h.generation) ? slot : NULL;
+}
+
+bool slot_map_erase(slot_map *m, slot_handle h)
+{
+	struct slot_entry *slot = slot_map_entry(m, h);
+	if (!slot)
+		return false;
+
+	// Fill the hole with the last element and repoint its slot.
+	Size last = slot_map_count(m) - 1;
+	if (slot->dense != last) {
+		uint32_t moved = m->dense_slot->front[last];
+		memcpy(slot_map_item(m, slot->dense), slot_map_item(m, last), m->item_size);
+		m->dense_slot->front[slot->dense] = moved;
+		m->slots->front[moved].dense = slot->dense;
+	}
+	LIST_BASE(m->dense)->length = last;
+	m->dense_slot->head.length = last;
+
+	if (++slot->generation == 0)
+		slot->generation = 1;
+	slot->dense = m->free_slot;
+	m->free_slot = h.index;
+	return true;
+}
+
+void *slot_map_get(const slot_map *m, slot_handle h)
+{
+	struct slot_entry *slot = slot_map_entry(m, h);
+	return slot ? slot_map_item(m, slot->dense) : NULL;
+}
+
+void slot_map_clear(slot_map *m)
+{
+	while (slot_map_count(m) > 0)
+		slot_map_erase(m, slot_map_handle_at(m, slot_map_count(m) - 1));
+}
+
+void slot_map_dispose(slot_map *m)
+{
+	List_dispose(m->dense);
+	List_dispose(m->dense_slot);
+	List_dispose(m->slots);
+	*m = (slot_map){ .item_size = m->item_size, .free_slot = SLOT_MAP_NONE };
+}
+
+Size slot_map_count(const slot_map *m)
+{
+	return List_length(m->dense);
+}
+
+void *slot_map_at(const slot_map *m, Size i)
+{
+	REQUIRE(0 <= i  &&  i < slot_map_count(m));
+	return slot_map_item(m, i);
+}
+
+slot_handle slot_map_handle_at(const slot_map *m, Size i)
+{
+	REQUIRE(0 <= i  &&  i < slot_map_count(m));
+	uint32_t index = m->dense_slot->front[i];
+	return (slot_handle){ .index = index, .generation = m->slots->front[index].generation };
+}
+
+
+
+//----------------------------------------------------------------------
+// Queue Module
+
+// Round cap up to a power of two and allocate that many items.
+void *Queue_alloc(Size *cap, Size sizeof_item)
+{
+	Size rounded = 1;
+	while (rounded < *cap) {
+		if (size_t_mult_overflows(rounded, 2))
+			return NULL;
+		rounded *= 2;
+	}
+
+	if (size_t_mult_overflows(rounded, sizeof_item))
+		return NULL;
+
+	*cap = rounded;
+	return malloc(rounded * sizeof_item);
+}
+
+void Queue_free(void *items)
+{
+	free(items);
+}
+
+
+//----------------------------------------------------------------------
+// Ring Module
+
+#define RING_MIN_CAPACITY  8
+
+void *Ring_grow(void *items, Size sizeof_item, Size *cap, Size head, Size length, Size min_cap)
+{
+	Size new_cap = *cap ? *cap : RING_MIN_CAPACITY;
+	while (new_cap < min_cap)
+		new_cap = try_size_mult(new_cap, 2, NULL, CURRENT_LOCATION);
+
+	void *grown = try_malloc(try_size_mult(new_cap, sizeof_item, NULL, CURRENT_LOCATION), NULL, CURRENT_LOCATION);
+	Ring_copy_out(items, sizeof_item, *cap, head, grown, length);
+	free(items);
+
+	*cap = new_cap;
+	return grown;
+}
+
+void Ring_copy_in(void *items, Size sizeof_item, Size cap, Size at, const void *src, Size count)
+{
+	if (count == 0)
+		return;
+
+	Size first = (count < cap - at) ? count : cap - at;
+	memcpy((char*)items + sizeof_item * at, src, sizeof_item * first);
+	memcpy(items, (const char*)src + sizeof_item * first, sizeof_item * (count - first));
+}
+
+void Ring_copy_out(const void *items, Size sizeof_item, Size cap, Size at, void *dst, Size count)
+{
+	if (count == 0)
+		return;
+
+	Size first = (count < cap - at) ? count : cap - at;
+	memcpy(dst, (const char*)items + sizeof_item * at, sizeof_item * first);
+	memcpy((char*)dst + sizeof_item * first, items, sizeof_item * (count - first));
+}
+
+void Ring_dispose(void *items)
+{
+	free(items);
+}
+
+
+
+//----------------------------------------------------------------------
+// bitset Module
+
+// Mask of the bits in use in the last word, all ones if it is full.
+static uint64_t bitset_tail_mask(Size length)
+{
+	int used = length % BITSET_WORD_BITS;
+	return used ? (1ull << used) - 1 : ~0ull;
+}
+
+struct bitset bitset_alloc(Arena *a, Size length)
+{
+	REQUIRE(length >= 0);
+	uint64_t *words = alloc(a, sizeof(uint64_t), _Alignof(uint64_t), BITSET_WORDS(length), ARENA_FILL_ZERO, CURRENT_LOCATION).data;
+	return (struct bitset){ words, length };
+}
+
+struct bitset bitset_create(Size length)
+{
+	struct bitset b = {0};
+	bitset_resize(&b, length);
+	return b;
+}
+
+void bitset_resize(struct bitset *b, Size length)
+{
+	REQUIRE(length >= 0);
+	Size old_words = BITSET_WORDS(b->length), new_words = BITSET_WORDS(length);
+
+	if (new_words == 0) {
+		bitset_dispose(b);
+		return;
+	}
+
+	if (new_words != old_words) {
+		size_t size = try_size_mult(new_words, sizeof(uint64_t), NULL, CURRENT_LOCATION);
+		uint64_t *words = realloc(b->words, size);
+		if (!words)
+			except_throw(NULL, STATUS_MALLOC_FAIL, CURRENT_LOCATION);
+		if (new_words > old_words)
+			memset(words + old_words, 0, (new_words - old_words) * sizeof(uint64_t));
+		b->words = words;
+	}
+
+	// Bits dropped by shrinking must not come back when growing again.
+	b->length = length;
+	b->words[new_words - 1] &= bitset_tail_mask(length);
+}
+
+void bitset_dispose(struct bitset *b)
+{
+	free(b->words);
+	*b = (struct bitset){0};
+}
+
+void bitset_fill(struct bitset *b, bool value)
+{
+	Size n = BITSET_WORDS(b->length);
+	if (n == 0)
+		return;
+
+	memset(b->words, value ? 0xFF : 0, n * sizeof(uint64_t));
+	b->words[n - 1] &= bitset_tail_mask(b->length);
+}
+
+Size bitset_count(struct bitset b)
+{
+	Size count = 0;
+	for (Size i = 0; i < BITSET_WORDS(b.length); ++i)
+		count += uint64_popcount(b.words[i]);
+	return count;
+}
+
+bool bitset_is_empty(struct bitset b)
+{
+	uint64_t any = 0;
+	for (Size i = 0; i < BITSET_WORDS(b.length); ++i)
+		any |= b.words[i];
+	return any == 0;
+}
+
+bool bitset_equals(struct bitset a, struct bitset b)
+{
+	return a.length == b.length
+		&& (a.length == 0 || memcmp(a.words, b.words, BITSET_WORDS(a.length) * sizeof(uint64_t)) == 0);
+}
+
+// Scan from bit `from` for a set bit in the words xor'd with flip.
+static Size bitset_scan(struct bitset b, Size from, uint64_t flip)
+{
+	if (from < 0)
+		from = 0;
+	if (from >= b.length)
+		return -1;
+
+	Size n = BITSET_WORDS(b.length);
+	Size i = from / BITSET_WORD_BITS;
+	uint64_t w = (b.words[i] ^ flip) & (~0ull << (from % BITSET_WORD_BITS));
+
+	for (;;) {
+		if (i == n - 1)
+			w &= bitset_tail_mask(b.length);
+		if (w)
+			return i * BITSET_WORD_BITS + uint64_trailing_zeros(w);
+		if (++i == n)
+			return -1;
+		w = b.words[i] ^ flip;
+	}
+}
+
+Size bitset_next_set(struct bitset b, Size from)
+{
+	return bitset_scan(b, from, 0);
+}
+
+Size bitset_next_clear(struct bitset b, Size from)
+{
+	return bitset_scan(b, from, ~0ull);
+}
+
+void bitset_and(struct bitset *dst, struct bitset src)
+{
+	REQUIRE(dst->length == src.length);
+	uint64_t *restrict d = dst->words;
+	const uint64_t *restrict s = src.words;
+	for (Size i = 0, n = BITSET_WORDS(src.length); i < n; ++i)
+		d[i] &= s[i];
+}
+
+void bitset_or(struct bitset *dst, struct bitset src)
+{
+	REQUIRE(dst->length == src.length);
+	uint64_t *restrict d = dst->words;
+	const uint64_t *restrict s = src.words;
+	for (Size i = 0, n = BITSET_WORDS(src.length); i < n; ++i)
+		d[i] |= s[i];
+}
+
+void bitset_xor(struct bitset *dst, struct bitset src)
+{
+	REQUIRE(dst->length == src.length);
+	uint64_t *restrict d = dst->words;
+	const uint64_t *restrict s = src.words;
+	for (Size i = 0, n = BITSET_WORDS(src.length); i < n; ++i)
+		d[i] ^= s[i];
+}
+
+void bitset_andnot(struct bitset *dst, struct bitset src)
+{
+	REQUIRE(dst->length == src.length);
+	uint64_t *restrict d = dst->words;
+	const uint64_t *restrict s = src.words;
+	for (Size i = 0, n = BITSET_WORDS(src.length); i < n; ++i)
+		d[i] &= ~s[i];
+}
+
+
+
+//----------------------------------------------------------------------
+// bitrank Module
+
+#define BITRANK_BLOCK_WORDS  (BITRANK_BLOCK_BITS / BITSET_WORD_BITS)
+
+static uint64_t *bitrank_words(Arena *a, Size count)
+{
+	return alloc(a, sizeof(uint64_t), _Alignof(uint64_t), count, ARENA_FILL_ZERO, CURRENT_LOCATION).data;
+}
+
+static uint32_t *bitrank_samples(Arena *a, Size count)
+{
+	return alloc(a, sizeof(uint32_t), _Alignof(uint32_t), count, ARENA_NO_FILL, CURRENT_LOCATION).data;
+}
+
+// Set bits before word w of block b, w in [0, 8).
+static Size bitrank_in_block(const struct bitrank *r, Size b, int w)
+{
+	return w ? (r->counts[2*b + 1] >> (9 * (w - 1))) & 0x1FF : 0;
+}
+
+static Size bitrank_ones_before(const struct bitrank *r, Size b)
+{
+	return r->counts[2*b];
+}
+
+static Size bitrank_zeros_before(const struct bitrank *r, Size b)
+{
+	return b * BITRANK_BLOCK_BITS - r->counts[2*b];
+}
+
+struct bitrank bitrank_build(Arena *a, struct bitset bits)
+{
+	Size words = BITSET_WORDS(bits.length);
+	struct bitrank r = { .bits = bits, .blocks = words / BITRANK_BLOCK_WORDS + 1 };
+	if (r.blocks > UINT32_MAX)
+		except_throw(NULL, STATUS_MATH_OVERFLOW, CURRENT_LOCATION);
+
+	r.counts = bitrank_words(a, 2 * r.blocks);
+	for (Size b = 0; b < r.blocks; ++b) {
+		uint64_t relative = 0;
+		Size in_block = 0;
+		for (int w = 0; w < BITRANK_BLOCK_WORDS; ++w) {
+			if (w > 0)
+				relative |= (uint64_t)in_block << (9 * (w - 1));
+			Size i = b * BITRANK_BLOCK_WORDS + w;
+			if (i < words)
+				in_block += uint64_popcount(bits.words[i]);
+		}
+		r.counts[2*b] = r.ones;
+		r.counts[2*b + 1] = relative;
+		r.ones += in_block;
+	}
+
+	Size zeros = bits.length - r.ones;
+	r.samples1 = bitrank_samples(a, r.ones / BITRANK_SAMPLE_RATE + 1);
+	r.samples0 = bitrank_samples(a, zeros / BITRANK_SAMPLE_RATE + 1);
+	r.samples1[0] = r.samples0[0] = 0;
+
+	Size next1 = BITRANK_SAMPLE_RATE, next0 = BITRANK_SAMPLE_RATE;
+	for (Size b = 0; b + 1 < r.blocks; ++b) {
+		Size ones_after = bitrank_ones_before(&r, b + 1);
+		Size zeros_after = bitrank_zeros_before(&r, b + 1);
+		for (; next1 < r.ones && next1 < ones_after; next1 += BITRANK_SAMPLE_RATE)
+			r.samples1[next1 / BITRANK_SAMPLE_RATE] = b;
+		for (; next0 < zeros && next0 < zeros_after; next0 += BITRANK_SAMPLE_RATE)
+			r.samples0[next0 / BITRANK_SAMPLE_RATE] = b;
+	}
+	for (; next1 < r.ones; next1 += BITRANK_SAMPLE_RATE)
+		r.samples1[next1 / BITRANK_SAMPLE_RATE] = r.blocks - 1;
+	for (; next0 < zeros; next0 += BITRANK_SAMPLE_RATE)
+		r.samples0[next0 / BITRANK_SAMPLE_RATE] = r.blocks - 1;
+
+	return r;
+}
+
+Size bitrank_rank(const struct bitrank *r, Size i)
+{
+	REQUIRE(0 <= i && i <= r->bits.length);
+	if (i == r->bits.length)
+		return r->ones;
+
+	Size word = i / BITSET_WORD_BITS;
+	Size b = word / BITRANK_BLOCK_WORDS;
+	uint64_t below = (1ull << (i % BITSET_WORD_BITS)) - 1;
+	return bitrank_ones_before(r, b) + bitrank_in_block(r, b, word % BITRANK_BLOCK_WORDS)
+		+ uint64_popcount(r->bits.words[word] & below);
+}
+
+Size bitrank_rank0(const struct bitrank *r, Size i)
+{
+	return i - bitrank_rank(r, i);
+}
+
+// Position of the kth set bit of w, counting from 0.
+static int uint64_select(uint64_t w, Size k)
+{
+	for (; k > 0; --k)
+		w &= w - 1;
+	return uint64_trailing_zeros(w);
+}
+
+// Find the kth set bit, or with zeros the kth clear one.
+static Size bitrank_find(const struct bitrank *r, Size k, bool zeros)
+{
+	Size total = zeros ? r->bits.length - r->ones : r->ones;
+	if (k < 0 || k >= total)
+		return -1;
+
+	// Samples exist for bits 0, RATE, 2 RATE... below the total; past the
+	// last one the search runs to the last block.
+	const uint32_t *samples = zeros ? r->samples0 : r->samples1;
+	Size j = k / BITRANK_SAMPLE_RATE;
+	Size lo = samples[j];
+	Size hi = ((j + 1) * BITRANK_SAMPLE_RATE < total) ? samples[j + 1] : r->blocks - 1;
+
+	// The last block in [lo, hi] with no more than k bits before it.
+	while (lo < hi) {
+		Size mid = lo + (hi - lo + 1) / 2;
+		Size before = zeros ? bitrank_zeros_before(r, mid) : bitrank_ones_before(r, mid);
+		if (before <= k)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+
+	Size b = lo;
+	k -= zeros ? bitrank_zeros_before(r, b) : bitrank_ones_before(r, b);
+
+	int w = BITRANK_BLOCK_WORDS - 1;
+	for (;; --w) {
+		Size before = bitrank_in_block(r, b, w);
+		if (zeros)
+			before = w * BITSET_WORD_BITS - before;
+		if (before <= k) {
+			k -= before;
+			break;
+		}
+	}
+
+	Size word = b * BITRANK_BLOCK_WORDS + w;
+	uint64_t bits = zeros ? ~r->bits.words[word] : r->bits.words[word];
+	return word * BITSET_WORD_BITS + uint64_select(bits, k);
+}
+
+Size bitrank_select(const struct bitrank *r, Size k)
+{
+	return bitrank_find(r, k, false);
+}
+
+Size bitrank_select0(const struct bitrank *r, Size k)
+{
+	return bitrank_find(r, k, true);
+}
+
+
+
+//----------------------------------------------------------------------
+// elias_fano Module
+
+static uint64_t elias_fano_low(const struct elias_fano *ef, Size i)
+{
+	if (ef->low_bits == 0)
+		return 0;
+
+	Size at = i * ef->low_bits;
+	Size word = at / 64;
+	int shift = at % 64;
+	uint64_t v = ef->low[word] >> shift;
+	if (shift + ef->low_bits > 64)
+		v |= ef->low[word + 1] << (64 - shift);
+	return v & ((1ull << ef->low_bits) - 1);
+}
+
+struct elias_fano elias_fano_build(Arena *a, const uint64_t values[], Size count)
+{
+	REQUIRE(count >= 0);
+	struct elias_fano ef = { .count = count };
+
+	uint64_t max = count ? values[count - 1] : 0;
+	if (count && max / count > 0)
+		ef.low_bits = 63 - uint64_leading_zeros(max / count);
+
+	Size high_length = try_size_add(count, (max >> ef.low_bits) + 1, NULL, CURRENT_LOCATION);
+	Size low_words = try_size_mult(count, ef.low_bits, NULL, CURRENT_LOCATION) / 64 + 1;
+	struct bitset high = bitset_alloc(a, high_length);
+	ef.low = bitrank_words(a, low_words);
+
+	uint64_t mask = (ef.low_bits ? 1ull << ef.low_bits : 1) - 1;
+	for (Size i = 0; i < count; ++i) {
+		REQUIRE(i == 0 || values[i - 1] <= values[i]);
+		bitset_set(&high, (values[i] >> ef.low_bits) + i);
+
+		Size at = i * ef.low_bits;
+		int shift = at % 64;
+		uint64_t low = values[i] & mask;
+		ef.low[at / 64] |= low << shift;
+		if (shift + ef.low_bits > 64)
+			ef.low[at / 64 + 1] |= low >> (64 - shift);
+	}
+
+	ef.high = bitrank_build(a, high);
+	return ef;
+}
+
+uint64_t elias_fano_get(const struct elias_fano *ef, Size i)
+{
+	if (LIST_CHECKED && !(0 <= i && i < ef->count))
+		List_bounds_failure(i, ef->count, CURRENT_LOCATION);
+
+	uint64_t high = bitrank_select(&ef->high, i) - i;
+	return high << ef->low_bits | elias_fano_low(ef, i);
+}
+
+Size elias_fano_lower_bound(const struct elias_fano *ef, uint64_t x)
+{
+	uint64_t bucket = x >> ef->low_bits;
+	Size buckets = ef->high.bits.length - ef->count;
+	if (bucket >= (uint64_t)buckets)
+		return ef->count;
+
+	// Values in the bucket follow its zero in the high bits, in order.
+	Size at = bucket ? bitrank_select0(&ef->high, bucket - 1) + 1 : 0;
+	Size i = at - bucket;
+	uint64_t low = x & ((ef->low_bits ? 1ull << ef->low_bits : 1) - 1);
+	for (; at < ef->high.bits.length && bitset_test(ef->high.bits, at); ++at, ++i)
+		if (elias_fano_low(ef, i) >= low)
+			return i;
+	return i;
+}
+
+Size elias_fano_bits(const struct elias_fano *ef)
+{
+	const struct bitrank *r = &ef->high;
+	Size words = (ef->count * ef->low_bits) / 64 + 1 + BITSET_WORDS(r->bits.length) + 2 * r->blocks;
+	Size samples = r->ones / BITRANK_SAMPLE_RATE + (r->bits.length - r->ones) / BITRANK_SAMPLE_RATE + 2;
+	return words * 64 + samples * 32;
+}
+
+
+
+//----------------------------------------------------------------------
+// rope Module
+
+#define ROPE_NEW(A_)  (rope*)alloc((A_), sizeof(rope), _Alignof(rope), 1, ARENA_NO_FILL, CURRENT_LOCATION).data
+
+static bool rope_is_leaf(const rope *r)
+{
+	return r && !r->left;
+}
+
+static const rope *rope_node(Arena *a, const rope *left, const rope *right)
+{
+	rope *n = ROPE_NEW(a);
+	*n = (rope){
+		.length = left->length + right->length,
+		.depth  = 1 + int_max(left->depth, right->depth),
+		.left   = left,
+		.right  = right,
+	};
+	return n;
+}
+
+// Rotate a node whose children differ in depth by two back into balance.
+static const rope *rope_balance(Arena *a, const rope *left, const rope *right)
+{
+	if (rope_depth(left) > rope_depth(right) + 1) {
+		if (rope_depth(left->left) >= rope_depth(left->right))
+			return rope_node(a, left->left, rope_node(a, left->right, right));
+		const rope *lr = left->right;
+		return rope_node(a, rope_node(a, left->left, lr->left),
+		                    rope_node(a, lr->right, right));
+	}
+
+	if (rope_depth(right) > rope_depth(left) + 1) {
+		if (rope_depth(right->right) >= rope_depth(right->left))
+			return rope_node(a, rope_node(a, left, right->left), right->right);
+		const rope *rl = right->left;
+		return rope_node(a, rope_node(a, left, rl->left),
+		                    rope_node(a, rl->right, right->right));
+	}
+
+	return rope_node(a, left, right);
+}
+
+static const rope *rope_join(Arena *a, const rope *left, const rope *right)
+{
+	if (!left  || !left->length)   return right;
+	if (!right || !right->length)  return left;
+
+	if (left->depth > right->depth + 1)
+		return rope_balance(a, left->left, rope_join(a, left->right, right));
+
+	if (right->depth > left->depth + 1)
+		return rope_balance(a, rope_join(a, left, right->left), right->right);
+
+	return rope_node(a, left, right);
+}
+
+// Copy two short leaves into one Arena chunk.
+static const rope *rope_merge_leaves(Arena *a, const rope *left, const rope *right)
+{
+	Size length = left->length + right->length;
+	Utf8 *chunk = alloc(a, 1, 1, length, ARENA_NO_FILL, CURRENT_LOCATION).data;
+	memcpy(chunk, left->leaf.data, left->length);
+	memcpy(chunk + left->length, right->leaf.data, right->length);
+	return rope_String(a, (String){ .data = chunk, .length = length });
+}
+
+const rope *rope_String(Arena *a, String s)
+{
+	if (String_is_empty(s))
+		return NULL;
+
+	rope *leaf = ROPE_NEW(a);
+	*leaf = (rope){ .length = s.length, .depth = 0, .leaf = s };
+	return leaf;
+}
+
+const rope *rope_strand(Arena *a, struct strand s)
+{
+	return rope_String(a, (String){ .data = (const Utf8*)s.front, .length = strand_length(s) });
+}
+
+const rope *rope_concat(Arena *a, const rope *left, const rope *right)
+{
+	if (rope_is_leaf(right) && right->length <= ROPE_SHORT_LEAF) {
+		if (rope_is_leaf(left) && left->length + right->length <= ROPE_SHORT_LEAF)
+			return rope_merge_leaves(a, left, right);
+
+		if (left && rope_is_leaf(left->right)
+		    && left->right->length + right->length <= ROPE_SHORT_LEAF)
+			return rope_join(a, left->left, rope_merge_leaves(a, left->right, right));
+	}
+
+	return rope_join(a, left, right);
+}
+
+const rope *rope_slice(Arena *a, const rope *r, Size from, Size to)
+{
+	assert(0 <= from && from <= to && to <= rope_length(r));
+
+	if (from == to)
+		return NULL;
+
+	if (from == 0 && to == r->length)
+		return r;
+
+	if (rope_is_leaf(r))
+		return rope_String(a, (String){ .data = r->leaf.data + from, .length = to - from });
+
+	Size mid = r->left->length;
+	if (to <= mid)
+		return rope_slice(a, r->left, from, to);
+	if (from >= mid)
+		return rope_slice(a, r->right, from - mid, to - mid);
+
+	return rope_join(a, rope_slice(a, r->left, from, mid),
+	                    rope_slice(a, r->right, 0, to - mid));
+}
+
+int rope_at(const rope *r, Size i)
+{
+	if (i < 0)  i += rope_length(r);
+	assertf(0 <= i && i < rope_length(r), "Rope index %td out of bounds [0,%td).", i, rope_length(r));
+
+	while (!rope_is_leaf(r)) {
+		if (i < r->left->length)
+			r = r->left;
+		else
+			i -= r->left->length, r = r->right;
+	}
+
+	return r->leaf.data[i];
+}
+
+static Utf8 *rope_copy_out(const rope *r, Utf8 *out)
+{
+	if (rope_is_leaf(r)) {
+		memcpy(out, r->leaf.data, r->length);
+		return out + r->length;
+	}
+	return rope_copy_out(r->right, rope_copy_out(r->left, out));
+}
+
+String rope_flatten(Arena *a, const rope *r)
+{
+	if (!r)
+		return (String){0};
+
+	// A single leaf is already flat.
+	if (rope_is_leaf(r))
+		return r->leaf;
+
+	Utf8 *flat = alloc(a, 1, 1, r->length, ARENA_NO_FILL, CURRENT_LOCATION).data;
+	rope_copy_out(r, flat);
+	return (String){ .data = flat, .length = r->length };
+}
+
+enum {  ROPE_IOV_BATCH = 64 };
+
+struct rope_iov_batch {
+	int           fd, count;
+	enum status   status;
+	struct iovec  iov[ROPE_IOV_BATCH];
+};
+
+static void rope_gather(const rope *r, struct rope_iov_batch *batch)
+{
+	if (!r || batch->status != STATUS_OK)
+		return;
+
+	if (!rope_is_leaf(r)) {
+		rope_gather(r->left, batch);
+		rope_gather(r->right, batch);
+		return;
+	}
+
+	batch->iov[batch->count++] = (struct iovec){ (void*)r->leaf.data, r->length };
+	if (batch->count == ROPE_IOV_BATCH) {
+		batch->status = writev_all(batch->fd, batch->iov, batch->count);
+		batch->count = 0;
+	}
+}
+
+enum status rope_write(const rope *r, int fd)
+{
+	struct rope_iov_batch batch = { .fd = fd, .status = STATUS_OK };
+	rope_gather(r, &batch);
+
+	if (batch.status == STATUS_OK && batch.count > 0)
+		batch.status = writev_all(fd, batch.iov, batch.count);
+
+	return batch.status;
+}
+
+
+//----------------------------------------------------------------------
+// utf8 Module
+
+#define UTF8_HIGH_BITS  0x8080808080808080ull
+
+static uint64_t utf8_load_word(const Utf8 *p)
+{
+	uint64_t w;
+	memcpy(&w, p, sizeof(w));
+	return w;
+}
+
+// Decode one well-formed sequence at p. Returns its length, or 0 if the
+// bytes at p aren't valid UTF-8.
+static int utf8_decode_at(const Utf8 *p, const Utf8 *end, int32_t *cp)
+{
+	Utf8 lo = 0x80, hi = 0xBF;
+	int32_t c = p[0];
+	int n = 1;
+
+	if (c < 0x80) {
+		*cp = c;
+		return 1;
+	}
+	else if (c < 0xC2)  return 0;
+	else if (c < 0xE0)  n = 2, c &= 0x1F;
+	else if (c < 0xF0)  n = 3, lo = (c == 0xE0) ? 0xA0 : lo, hi = (c == 0xED) ? 0x9F : hi, c &= 0x0F;
+	else if (c < 0xF5)  n = 4, lo = (c == 0xF0) ? 0x90 : lo, hi = (c == 0xF4) ? 0x8F : hi, c &= 0x07;
+	else                return 0;
+
+	if (end - p < n || p[1] < lo || p[1] > hi)
+		return 0;
+
+	c = (c << 6) | (p[1] & 0x3F);
+	for (int i = 2; i < n; ++i) {
+		if (!utf8_is_continuation(p[i]))
+			return 0;
+		c = (c << 6) | (p[i] & 0x3F);
+	}
+
+	*cp = c;
+	return n;
+}
+
+Size utf8_invalid_at(String s)
+{
+	const Utf8 *p = s.data, *end = s.data + s.length;
+
+	while (p < end) {
+		while (end - p >= 8 && !(utf8_load_word(p) & UTF8_HIGH_BITS))
+			p += 8;
+
+		if (p == end)
+			break;
+
+		int32_t cp;
+		int n = utf8_decode_at(p, end, &cp);
+		if (!n)
+			return p - s.data;
+		p += n;
+	}
+
+	return s.length;
+}
+
+bool utf8_is_valid(String s)
+{
+	return utf8_invalid_at(s) == s.length;
+}
+
+Size utf8_count(String s)
+{
+	const Utf8 *p = s.data, *end = s.data + s.length;
+	Size continuations = 0;
+
+	// A continuation byte has its high bit set and the next bit clear.
+	for (; end - p >= 8; p += 8) {
+		uint64_t w = utf8_load_word(p);
+		continuations += uint64_popcount(w & ~(w << 1) & UTF8_HIGH_BITS);
+	}
+	for (; p < end; ++p)
+		continuations += utf8_is_continuation(*p);
+
+	return s.length - continuations;
+}
+
+Size utf8_offset(String s, Size n)
+{
+	Size i = 0;
+	for (; i < s.length; ++i)
+		if (!utf8_is_continuation(s.data[i]) && n-- == 0)
+			break;
+	return i;
+}
+
+int32_t utf8_next(String *s)
+{
+	if (s->length <= 0)
+		return UTF8_INVALID;
+
+	int32_t cp = UTF8_INVALID;
+	int n = utf8_decode_at(s->data, s->data + s->length, &cp);
+
+	// Skip one byte of a malformed sequence so decoding can resync.
+	if (!n) {
+		n  = 1;
+		cp = UTF8_INVALID;
+	}
+
+	s->data   += n;
+	s->length -= n;
+	return cp;
+}
+
+int utf8_encode(int32_t cp, Utf8 out[UTF8_MAX_LEN])
+{
+	if (cp < 0 || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+		return 0;
+
+	if (cp < 0x80) {
+		out[0] = cp;
+		return 1;
+	}
+	if (cp < 0x800) {
+		out[0] = 0xC0 | (cp >> 6);
+		out[1] = 0x80 | (cp & 0x3F);
+		return 2;
+	}
+	if (cp < 0x10000) {
+		out[0] = 0xE0 | (cp >> 12);
+		out[1] = 0x80 | ((cp >> 6) & 0x3F);
+		out[2] = 0x80 | (cp & 0x3F);
+		return 3;
+	}
+	out[0] = 0xF0 | (cp >> 18);
+	out[1] = 0x80 | ((cp >> 12) & 0x3F);
+	out[2] = 0x80 | ((cp >> 6) & 0x3F);
+	out[3] = 0x80 | (cp & 0x3F);
+	return 4;
+}
+
+enum status strbuf_put_utf8(struct strbuf *buf, int32_t cp)
+{
+	Utf8 bytes[UTF8_MAX_LEN];
+	int n = utf8_encode(cp, bytes);
+
+	if (!n)
+		return STATUS_ERROR;
+
+	return strbuf_cat(buf, strand_init_n((const char*)bytes, n));
+}
+
+
+
+//----------------------------------------------------------------------
+// ac Module
+
+static int32_t *ac_table(Arena *a, Size count)
+{
+	return alloc(a, sizeof(int32_t), _Alignof(int32_t), count, ARENA_FILL_ZERO, CURRENT_LOCATION).data;
+}
+
+// Build the pattern trie, then turn it into a DFA breadth first: a
+// missing edge takes the same edge as the failure state, whose row is
+// already complete because it is shallower.
+const ac_matcher *ac_compile(Arena *a, const struct strand patterns[], int count)
+{
+	ac_matcher *ac = alloc(a, sizeof(ac_matcher), _Alignof(ac_matcher), 1, ARENA_FILL_ZERO, CURRENT_LOCATION).data;
+
+	int max_states = 1;
+	for (int i = 0; i < count; ++i) {
+		REQUIRE(!strand_is_empty(patterns[i]));
+		max_states += strand_length(patterns[i]);
+		for (const char *p = patterns[i].front; p < patterns[i].back; ++p)
+			ac->byte_class[(uint8_t)*p] = 1;
+	}
+
+	int classes = 1;
+	for (int b = 0; b < 256; ++b)
+		if (ac->byte_class[b])
+			ac->byte_class[b] = classes++;
+
+	// Zero is the root, which is never the target of a trie edge.
+	int32_t *next   = ac_table(a, (Size)max_states * classes);
+	int32_t *first  = ac_table(a, max_states);
+	int32_t *same   = ac_table(a, count);
+	int32_t *length = ac_table(a, count);
+	int states = 1;
+
+	for (int s = 0; s < max_states; ++s)
+		first[s] = -1;
+
+	// Insert in reverse so duplicate patterns are reported in index order.
+	for (int i = count - 1; i >= 0; --i) {
+		int32_t s = 0;
+		for (const char *p = patterns[i].front; p < patterns[i].back; ++p) {
+			int32_t *edge = &next[s * classes + ac->byte_class[(uint8_t)*p]];
+			if (!*edge)
+				*edge = states++;
+			s = *edge;
+		}
+		length[i] = strand_length(patterns[i]);
+		same[i] = first[s];
+		first[s] = i;
+	}
+
+	int32_t *fail   = ac_table(a, states);
+	int32_t *output = ac_table(a, states);
+	int32_t *suffix = ac_table(a, states);
+	int32_t *queue  = ac_table(a, states);
+	int head = 0, tail = 0;
+
+	for (int c = 0; c < classes; ++c)
+		if (next[c])
+			queue[tail++] = next[c];
+
+	while (head < tail) {
+		int32_t s = queue[head++];
+		suffix[s] = output[fail[s]];
+		output[s] = (first[s] >= 0) ? s : suffix[s];
+
+		for (int c = 0; c < classes; ++c) {
+			int32_t *edge = &next[s * classes + c];
+			int32_t fallback = next[fail[s] * classes + c];
+			if (*edge) {
+				fail[*edge] = fallback;
+				queue[tail++] = *edge;
+			}
+			else
+				*edge = fallback;
+		}
+	}
+
+	ac->patterns = count;
+	ac->states   = states;
+	ac->classes  = classes;
+	ac->next     = next;
+	ac->output   = output;
+	ac->suffix   = suffix;
+	ac->first    = first;
+	ac->same     = same;
+	ac->length   = length;
+	return ac;
+}
+
+bool ac_contains(const ac_matcher *ac, struct strand text)
+{
+	int32_t state = 0;
+	for (const uint8_t *p = (const uint8_t*)text.front; p < (const uint8_t*)text.back; ++p) {
+		state = ac->next[state * ac->classes + ac->byte_class[*p]];
+		if (ac->output[state])
+			return true;
+	}
+	return false;
+}
+
+ac_scanner ac_scan(const ac_matcher *ac, struct strand text)
+{
+	ac_scanner scan = { .ac = ac, .pattern = -1 };
+	ac_feed(&scan, text);
+	return scan;
+}
+
+void ac_feed(ac_scanner *scan, struct strand chunk)
+{
+	scan->front = (const uint8_t*)chunk.front;
+	scan->back  = (const uint8_t*)chunk.back;
+}
+
+bool ac_next(ac_scanner *scan, ac_match *match)
+{
+	const ac_matcher *ac = scan->ac;
+
+	while (scan->pattern < 0) {
+		const uint8_t *p = scan->front;
+		int32_t state = scan->state, hit = 0;
+
+		while (p < scan->back) {
+			state = ac->next[state * ac->classes + ac->byte_class[*p++]];
+			if ((hit = ac->output[state]))
+				break;
+		}
+
+		scan->offset += p - scan->front;
+		scan->front = p;
+		scan->state = state;
+
+		if (!hit)
+			return false;
+
+		scan->hit = hit;
+		scan->pattern = ac->first[hit];
+	}
+
+	int pattern = scan->pattern;
+	*match = (ac_match){
+		.pattern = pattern,
+		.start   = scan->offset - ac->length[pattern],
+		.end     = scan->offset,
+	};
+
+	// Next is a duplicate of this pattern, else the longest suffix match.
+	scan->pattern = ac->same[pattern];
+	if (scan->pattern < 0) {
+		scan->hit = ac->suffix[scan->hit];
+		if (scan->hit)
+			scan->pattern = ac->first[scan->hit];
+	}
+
+	return true;
+}
+
+//----------------------------------------------------------------------
+// regex Module
+
+#define RE_NEW(A_, T_, N_)  (T_*)alloc((A_), sizeof(T_), _Alignof(T_), (N_), ARENA_FILL_ZERO, CURRENT_LOCATION).data
+
+// DFA states cached per program before the cache is flushed.
+#define REGEX_CACHE_STATES  128
+
+enum {
+	REGEX_UNKNOWN    = -1,    // transition not computed yet
+	REGEX_DEAD       = -2,    // no match is possible any more
+	REGEX_ANCHORED   =  0,    // start state ids, kept across flushes
+	REGEX_UNANCHORED =  1,
+};
+
+enum re_kind { RE_EMPTY, RE_SET, RE_CAT, RE_ALT, RE_STAR, RE_PLUS, RE_QUEST };
+
+struct re_node {
+	enum re_kind          kind;
+	const struct re_node *left, *right;
+	uint8_t               set[32];
+};
+
+enum nfa_kind { NFA_SET, NFA_SPLIT, NFA_MATCH };
+
+struct nfa_state {
+	enum nfa_kind kind;
+	int32_t       out, out1;
+	uint8_t       set[32];
+};
+
+// One direction of the pattern: its NFA and the DFA states built so far.
+// A DFA state is the sorted set of NFA states it stands for, kept in
+// pool, and whether it restarts the NFA at every byte.
+struct re_prog {
+	struct nfa_state *states;
+	int32_t  count;
+	int32_t  start;
+
+	int32_t  dfa_count;
+	int32_t *next;          // [REGEX_CACHE_STATES][classes]
+	uint8_t *accept;
+	uint8_t *unanchored;
+	int32_t *set_front;
+	int32_t *set_length;
+	int32_t *pool;
+	int32_t  pool_used;
+	int32_t *table;         // open addressed, 2 * REGEX_CACHE_STATES
+	int32_t *scratch;
+	int32_t *stack;
+	uint32_t *mark;
+	uint32_t generation;
+};
+
+struct regex {
+	uint8_t        byte_class[256];
+	uint8_t        class_byte[256];
+	int            classes;
+	bool           anchor_start, anchor_end;
+	int            prefix;      // byte every match starts with, or -1
+	struct re_prog forward, reverse;
+};
+
+static bool re_set_has(const uint8_t set[32], int b)
+{
+	return set[b >> 3] & (1 << (b & 7));
+}
+
+static void re_set_add(uint8_t set[32], int b)
+{
+	set[b >> 3] |= 1 << (b & 7);
+}
+
+static void re_set_range(uint8_t set[32], int lo, int hi)
+{
+	for (int b = lo; b <= hi; ++b)
+		re_set_add(set, b);
+}
+
+static void re_set_invert(uint8_t set[32])
+{
+	for (int i = 0; i < 32; ++i)
+		set[i] = ~set[i];
+}
+
+//----------------------------------------------------------------------
+// Parsing into a syntax tree
+
+struct re_parser {
+	Arena      *arena;
+	const char *at, *end;
+	int         nodes;
+	bool        failed;
+};
+
+static struct re_node *re_node(struct re_parser *p, enum re_kind kind, const struct re_node *left, const struct re_node *right)
+{
+	struct re_node *n = RE_NEW(p->arena, struct re_node, 1);
+	n->kind  = kind;
+	n->left  = left;
+	n->right = right;
+	++p->nodes;
+	return n;
+}
+
+static struct re_node *re_fail(struct re_parser *p)
+{
+	p->failed = true;
+	return NULL;
+}
+
+static bool re_more(const struct re_parser *p)
+{
+	return p->at < p->end;
+}
+
+static struct re_node *re_concat(struct re_parser *p, struct re_node *left, struct re_node *right)
+{
+	return left ? re_node(p, RE_CAT, left, right) : right;
+}
+
+// Add the bytes named by the escape after a backslash to set.
+static void re_parse_escape(struct re_parser *p, uint8_t set[32])
+{
+	if (!re_more(p)) {
+		re_fail(p);
+		return;
+	}
+
+	int c = (unsigned char)*p->at++;
+	uint8_t class[32] = {0};
+
+	switch (c) {
+		case 'd': case 'D':
+			re_set_range(class, '0', '9');
+			break;
+		case 'w': case 'W':
+			re_set_range(class, '0', '9');
+			re_set_range(class, 'a', 'z');
+			re_set_range(class, 'A', 'Z');
+			re_set_add(class, '_');
+			break;
+		case 's': case 'S':
+			for (const char *s = " \t\n\r\f\v"; *s; ++s)
+				re_set_add(class, *s);
+			break;
+		case 'n':  re_set_add(set, '\n');  return;
+		case 'r':  re_set_add(set, '\r');  return;
+		case 't':  re_set_add(set, '\t');  return;
+		default:
+			if (isalnum(c))
+				re_fail(p);
+			re_set_add(set, c);
+			return;
+	}
+
+	if (isupper(c))
+		re_set_invert(class);
+	for (int i = 0; i < 32; ++i)
+		set[i] |= class[i];
+}
+
+// Parse a class after its opening bracket. negate is '^' or '!'.
+static struct re_node *re_parse_class(struct re_parser *p, char negate)
+{
+	struct re_node *n = re_node(p, RE_SET, NULL, NULL);
+	bool negated = re_more(p) && *p->at == negate;
+	p->at += negated;
+
+	for (bool first = true; re_more(p) && (first || *p->at != ']'); first = false) {
+		int lo = (unsigned char)*p->at++;
+		if (lo == '\\') {
+			re_parse_escape(p, n->set);
+			continue;
+		}
+		if (p->end - p->at >= 2 && p->at[0] == '-' && p->at[1] != ']') {
+			int hi = (unsigned char)p->at[1];
+			p->at += 2;
+			if (hi < lo)
+				return re_fail(p);
+			re_set_range(n->set, lo, hi);
+		}
+		else
+			re_set_add(n->set, lo);
+	}
+
+	if (!re_more(p))
+		return re_fail(p);
+	++p->at;
+
+	if (negated)
+		re_set_invert(n->set);
+	return n;
+}
+
+static struct re_node *re_parse_alt(struct re_parser *p);
+
+static struct re_node *re_parse_atom(struct re_parser *p)
+{
+	int c = (unsigned char)*p->at++;
+	struct re_node *n;
+
+	switch (c) {
+		case '(':
+			n = re_parse_alt(p);
+			if (!re_more(p) || *p->at != ')')
+				return re_fail(p);
+			++p->at;
+			return n;
+		case '[':
+			return re_parse_class(p, '^');
+		case '.':
+			n = re_node(p, RE_SET, NULL, NULL);
+			re_set_range(n->set, 0, 255);
+			n->set['\n' >> 3] &= ~(1 << ('\n' & 7));
+			return n;
+		case '\\':
+			n = re_node(p, RE_SET, NULL, NULL);
+			re_parse_escape(p, n->set);
+			return n;
+		case '*': case '+': case '?': case ')': case '^': case '$':
+			return re_fail(p);
+		default:
+			n = re_node(p, RE_SET, NULL, NULL);
+			re_set_add(n->set, c);
+			return n;
+	}
+}
+
+static struct re_node *re_parse_concat(struct re_parser *p)
+{
+	struct re_node *result = NULL;
+
+	while (re_more(p) && *p->at != '|' && *p->at != ')' && !p->failed) {
+		struct re_node *n = re_parse_atom(p);
+		for (; re_more(p) && strchr("*+?", *p->at); ++p->at) {
+			enum re_kind kind = (*p->at == '*') ? RE_STAR : (*p->at == '+') ? RE_PLUS : RE_QUEST;
+			n = re_node(p, kind, n, NULL);
+		}
+		result = re_concat(p, result, n);
+	}
+
+	return result ? result : re_node(p, RE_EMPTY, NULL, NULL);
+}
+
+static struct re_node *re_parse_alt(struct re_parser *p)
+{
+	struct re_node *n = re_parse_concat(p);
+	while (re_more(p) && *p->at == '|' && !p->failed) {
+		++p->at;
+		n = re_node(p, RE_ALT, n, re_parse_concat(p));
+	}
+	return n;
+}
+
+static struct re_node *glob_parse(struct re_parser *p)
+{
+	struct re_node *result = NULL;
+
+	while (re_more(p) && !p->failed) {
+		int c = (unsigned char)*p->at++;
+		struct re_node *n;
+
+		if (c == '[')
+			n = re_parse_class(p, '!');
+		else {
+			n = re_node(p, RE_SET, NULL, NULL);
+			if (c == '*' || c == '?')
+				re_set_range(n->set, 0, 255);
+			else if (c == '\\' && re_more(p))
+				re_set_add(n->set, (unsigned char)*p->at++);
+			else
+				re_set_add(n->set, c);
+			if (c == '*')
+				n = re_node(p, RE_STAR, n, NULL);
+		}
+		result = re_concat(p, result, n);
+	}
+
+	return result ? result : re_node(p, RE_EMPTY, NULL, NULL);
+}
+
+static bool re_nullable(const struct re_node *n)
+{
+	switch (n->kind) {
+		case RE_SET:   return false;
+		case RE_CAT:   return re_nullable(n->left) && re_nullable(n->right);
+		case RE_ALT:   return re_nullable(n->left) || re_nullable(n->right);
+		case RE_PLUS:  return re_nullable(n->left);
+		default:       return true;
+	}
+}
+
+// The byte every match of n starts with, or -1.
+static int re_first_byte(const struct re_node *n)
+{
+	int b = -1;
+
+	switch (n->kind) {
+		case RE_SET:
+			for (int i = 0; i < 256; ++i)
+				if (re_set_has(n->set, i)) {
+					if (b >= 0)
+						return -1;
+					b = i;
+				}
+			return b;
+		case RE_CAT:
+			return re_nullable(n->left) ? -1 : re_first_byte(n->left);
+		case RE_ALT:
+			b = re_first_byte(n->left);
+			return (b == re_first_byte(n->right)) ? b : -1;
+		case RE_PLUS:
+			return re_first_byte(n->left);
+		default:
+			return -1;
+	}
+}
+
+//----------------------------------------------------------------------
+// Compiling to an NFA
+
+static int32_t nfa_add(struct re_prog *p, enum nfa_kind kind, int32_t out, int32_t out1)
+{
+	struct nfa_state *s = &p->states[p->count];
+	s->kind = kind;
+	s->out  = out;
+	s->out1 = out1;
+	return p->count++;
+}
+
+// Emit the states for n, continuing at next, and return the first one.
+// A reversed program matches the text read backwards.
+static int32_t nfa_compile(struct re_prog *p, const struct re_node *n, int32_t next, bool reversed)
+{
+	int32_t s;
+
+	switch (n->kind) {
+		case RE_EMPTY:
+			return next;
+		case RE_SET:
+			s = nfa_add(p, NFA_SET, next, -1);
+			memcpy(p->states[s].set, n->set, sizeof(n->set));
+			return s;
+		case RE_CAT:
+			if (reversed)
+				return nfa_compile(p, n->right, nfa_compile(p, n->left, next, reversed), reversed);
+			return nfa_compile(p, n->left, nfa_compile(p, n->right, next, reversed), reversed);
+		case RE_ALT:
+			s = nfa_compile(p, n->left, next, reversed);
+			return nfa_add(p, NFA_SPLIT, s, nfa_compile(p, n->right, next, reversed));
+		case RE_QUEST:
+			return nfa_add(p, NFA_SPLIT, nfa_compile(p, n->left, next, reversed), next);
+		case RE_STAR:
+			s = nfa_add(p, NFA_SPLIT, -1, next);
+			p->states[s].out = nfa_compile(p, n->left, s, reversed);
+			return s;
+		case RE_PLUS:
+			s = nfa_add(p, NFA_SPLIT, -1, next);
+			return p->states[s].out = nfa_compile(p, n->left, s, reversed);
+	}
+	return next;
+}
+
+// Split the bytes into classes no NFA set tells apart.
+static void re_byte_classes(regex *re)
+{
+	const struct re_prog *p = &re->forward;
+	int classes = 1;
+
+	for (int s = 0; s < p->count; ++s) {
+		if (p->states[s].kind != NFA_SET)
+			continue;
+
+		int16_t remap[512];
+		memset(remap, -1, sizeof(remap));
+		int refined = 0;
+
+		for (int b = 0; b < 256; ++b) {
+			int key = re->byte_class[b] * 2 + re_set_has(p->states[s].set, b);
+			if (remap[key] < 0)
+				remap[key] = refined++;
+			re->byte_class[b] = remap[key];
+		}
+		classes = refined;
+	}
+
+	re->classes = classes;
+	for (int b = 255; b >= 0; --b)
+		re->class_byte[re->byte_class[b]] = b;
+}
+
+//----------------------------------------------------------------------
+// The lazy DFA
+
+static int re_compare_ids(const void *a, const void *b)
+{
+	int32_t x = *(const int32_t*)a, y = *(const int32_t*)b;
+	return (x > y) - (x < y);
+}
+
+// Add the NFA states reachable from s without reading a byte.
+static void re_closure(struct re_prog *p, int32_t s, int *n)
+{
+	int top = 0;
+	p->stack[top++] = s;
+
+	while (top > 0) {
+		s = p->stack[--top];
+		if (p->mark[s] == p->generation)
+			continue;
+		p->mark[s] = p->generation;
+
+		if (p->states[s].kind == NFA_SPLIT) {
+			p->stack[top++] = p->states[s].out1;
+			p->stack[top++] = p->states[s].out;
+		}
+		else
+			p->scratch[(*n)++] = s;
+	}
+}
+
+static void re_next_generation(struct re_prog *p)
+{
+	if (++p->generation == 0) {
+		memset(p->mark, 0, p->count * sizeof(p->mark[0]));
+		p->generation = 1;
+	}
+}
+
+// Find or add the DFA state for the n NFA states in scratch. Returns
+// REGEX_UNKNOWN when the cache is full.
+static int32_t dfa_state(struct re_prog *p, int classes, int n, bool unanchored)
+{
+	qsort(p->scratch, n, sizeof(p->scratch[0]), re_compare_ids);
+
+	uint64_t h = hash(byte_span_init_n((Byte*)p->scratch, n * sizeof(p->scratch[0]))) ^ unanchored;
+	int mask = 2 * REGEX_CACHE_STATES - 1;
+
+	for (int i = h & mask; ; i = (i + 1) & mask) {
+		int32_t id = p->table[i];
+		if (id < 0) {
+			if (p->dfa_count == REGEX_CACHE_STATES)
+				return REGEX_UNKNOWN;
+
+			id = p->table[i] = p->dfa_count++;
+			p->set_front[id]  = p->pool_used;
+			p->set_length[id] = n;
+			p->unanchored[id] = unanchored;
+			p->accept[id] = false;
+			for (int k = 0; k < n; ++k) {
+				p->pool[p->pool_used++] = p->scratch[k];
+				p->accept[id] |= (p->states[p->scratch[k]].kind == NFA_MATCH);
+			}
+			for (int c = 0; c < classes; ++c)
+				p->next[id * classes + c] = REGEX_UNKNOWN;
+			return id;
+		}
+
+		if (p->set_length[id] == n && p->unanchored[id] == unanchored
+				&& !memcmp(&p->pool[p->set_front[id]], p->scratch, n * sizeof(p->scratch[0])))
+			return id;
+	}
+}
+
+// Empty the cache, keeping only the two start states.
+static void dfa_flush(struct re_prog *p, int classes)
+{
+	p->dfa_count = 0;
+	p->pool_used = 0;
+	memset(p->table, -1, 2 * REGEX_CACHE_STATES * sizeof(p->table[0]));
+
+	for (int unanchored = 0; unanchored <= 1; ++unanchored) {
+		int n = 0;
+		re_next_generation(p);
+		re_closure(p, p->start, &n);
+		dfa_state(p, classes, n, unanchored);
+	}
+}
+
+static int32_t dfa_step(const regex *re, struct re_prog *p, int32_t from, int cls)
+{
+	int byte = re->class_byte[cls];
+	const int32_t *set = &p->pool[p->set_front[from]];
+	int n = 0;
+
+	re_next_generation(p);
+	for (int i = 0; i < p->set_length[from]; ++i) {
+		const struct nfa_state *s = &p->states[set[i]];
+		if (s->kind == NFA_SET && re_set_has(s->set, byte))
+			re_closure(p, s->out, &n);
+	}
+	if (p->unanchored[from])
+		re_closure(p, p->start, &n);
+
+	int32_t to = REGEX_DEAD;
+	if (n > 0 || p->unanchored[from])
+		to = dfa_state(p, re->classes, n, p->unanchored[from]);
+
+	if (to == REGEX_UNKNOWN) {
+		// The start states only use the front of the pool.
+		bool unanchored = p->unanchored[from];
+		int32_t *saved = &p->pool[(REGEX_CACHE_STATES - 1) * p->count];
+		memcpy(saved, p->scratch, n * sizeof(saved[0]));
+		dfa_flush(p, re->classes);
+		memcpy(p->scratch, saved, n * sizeof(saved[0]));
+		return dfa_state(p, re->classes, n, unanchored);
+	}
+
+	p->next[from * re->classes + cls] = to;
+	return to;
+}
+
+static inline int32_t dfa_next(const regex *re, struct re_prog *p, int32_t state, uint8_t byte)
+{
+	int cls = re->byte_class[byte];
+	int32_t to = p->next[state * re->classes + cls];
+	return (to == REGEX_UNKNOWN) ? dfa_step(re, p, state, cls) : to;
+}
+
+//----------------------------------------------------------------------
+// Compiling and matching
+
+static void re_prog_init(Arena *a, struct re_prog *p, const struct re_node *root, int nodes, bool reversed)
+{
+	p->states = RE_NEW(a, struct nfa_state, nodes + 1);
+	p->start  = nfa_compile(p, root, nfa_add(p, NFA_MATCH, -1, -1), reversed);
+}
+
+static void re_prog_cache(Arena *a, struct re_prog *p, int classes)
+{
+	p->next       = RE_NEW(a, int32_t, REGEX_CACHE_STATES * classes);
+	p->accept     = RE_NEW(a, uint8_t, REGEX_CACHE_STATES);
+	p->unanchored = RE_NEW(a, uint8_t, REGEX_CACHE_STATES);
+	p->set_front  = RE_NEW(a, int32_t, REGEX_CACHE_STATES);
+	p->set_length = RE_NEW(a, int32_t, REGEX_CACHE_STATES);
+	p->pool       = RE_NEW(a, int32_t, REGEX_CACHE_STATES * p->count);
+	p->table      = RE_NEW(a, int32_t, 2 * REGEX_CACHE_STATES);
+	p->scratch    = RE_NEW(a, int32_t, p->count);
+	p->stack      = RE_NEW(a, int32_t, 2 * p->count + 1);
+	p->mark       = RE_NEW(a, uint32_t, p->count);
+	dfa_flush(p, classes);
+}
+
+static regex *regex_build(Arena *a, const struct re_node *root, int nodes, bool anchor_start, bool anchor_end)
+{
+	regex *re = RE_NEW(a, regex, 1);
+	re->anchor_start = anchor_start;
+	re->anchor_end   = anchor_end;
+	re->prefix       = re_first_byte(root);
+
+	re_prog_init(a, &re->forward, root, nodes, false);
+	re_prog_init(a, &re->reverse, root, nodes, true);
+	re_byte_classes(re);
+	re_prog_cache(a, &re->forward, re->classes);
+	re_prog_cache(a, &re->reverse, re->classes);
+	return re;
+}
+
+// Whether a $ at the end of pattern is an anchor rather than escaped.
+static bool re_ends_with_anchor(struct strand pattern)
+{
+	const char *p = pattern.back;
+	if (p == pattern.front || p[-1] != '$')
+		return false;
+
+	int slashes = 0;
+	for (--p; p > pattern.front && p[-1] == '\\'; --p)
+		++slashes;
+	return slashes % 2 == 0;
+}
+
+enum status regex_compile(Arena *a, struct strand pattern, regex **re)
+{
+	bool anchor_start = !strand_is_empty(pattern) && *pattern.front == '^';
+	bool anchor_end = re_ends_with_anchor(pattern);
+
+	struct re_parser p = {
+		.arena = a,
+		.at    = pattern.front + anchor_start,
+		.end   = pattern.back - anchor_end,
+	};
+
+	struct re_node *root = re_parse_alt(&p);
+	if (p.failed || re_more(&p))
+		return STATUS_ERROR;
+
+	*re = regex_build(a, root, p.nodes, anchor_start, anchor_end);
+	return STATUS_OK;
+}
+
+enum status glob_compile(Arena *a, struct strand pattern, regex **re)
+{
+	struct re_parser p = { .arena = a, .at = pattern.front, .end = pattern.back };
+
+	struct re_node *root = glob_parse(&p);
+	if (p.failed)
+		return STATUS_ERROR;
+
+	*re = regex_build(a, root, p.nodes, true, true);
+	return STATUS_OK;
+}
+
+bool regex_match(regex *re, struct strand text)
+{
+	struct re_prog *p = &re->forward;
+	int32_t state = REGEX_ANCHORED;
+
+	for (const char *at = text.front; at < text.back; ++at)
+		if ((state = dfa_next(re, p, state, *at)) == REGEX_DEAD)
+			return false;
+
+	return p->accept[state];
+}
+
+bool regex_search(regex *re, struct strand text)
+{
+	struct re_prog *p = &re->forward;
+	const char *at = text.front;
+	int32_t state = re->anchor_start ? REGEX_ANCHORED : REGEX_UNANCHORED;
+	bool stop_early = !re->anchor_end;
+
+	if (stop_early && p->accept[state])
+		return true;
+
+	while (at < text.back) {
+		// Skip ahead to where a match could start.
+		if (state == REGEX_UNANCHORED && re->prefix >= 0) {
+			at = memchr(at, re->prefix, text.back - at);
+			if (!at)
+				return false;
+		}
+
+		state = dfa_next(re, p, state, *at++);
+		if (state == REGEX_DEAD)
+			return false;
+		if (stop_early && p->accept[state])
+			return true;
+	}
+
+	return p->accept[state];
+}
+
+// The leftmost start is found by running the reversed pattern back from
+// the end of the text, then the longest match from there forwards.
+bool regex_find(regex *re, struct strand text, struct strand *found)
+{
+	Size length = strand_length(text);
+	Size start = 0, end = -1;
+
+	if (!re->anchor_start) {
+		if (!regex_search(re, text))
+			return false;
+
+		struct re_prog *p = &re->reverse;
+		int32_t state = re->anchor_end ? REGEX_ANCHORED : REGEX_UNANCHORED;
+		start = p->accept[state] ? length : -1;
+
+		for (Size i = length; i > 0; ) {
+			state = dfa_next(re, p, state, text.front[--i]);
+			if (state == REGEX_DEAD)
+				break;
+			if (p->accept[state])
+				start = i;
+		}
+		if (start < 0)
+			return false;
+	}
+
+	struct re_prog *p = &re->forward;
+	int32_t state = REGEX_ANCHORED;
+	if (p->accept[state])
+		end = start;
+
+	for (Size i = start; i < length; ) {
+		state = dfa_next(re, p, state, text.front[i++]);
+		if (state == REGEX_DEAD)
+			break;
+		if (p->accept[state])
+			end = i;
+	}
+
+	if (end < 0 || (re->anchor_end && end != length))
+		return false;
+
+	*found = strand_init_n(text.front + start, end - start);
+	return true;
+}
+
+//----------------------------------------------------------------------
+// diff Module
+
+// Advance one 64-row block of the bit-vector columns by one char. hin is
+// the horizontal delta entering the block's top row, the result the
+// delta leaving its bottom row.
+static int myers_block(uint64_t *pv, uint64_t *mv, uint64_t eq, int hin, uint64_t high)
+{
+	uint64_t xv = eq | *mv;
+	if (hin < 0)
+		eq |= 1;
+	uint64_t xh = (((eq & *pv) + *pv) ^ *pv) | eq;
+	uint64_t ph = *mv | ~(xh | *pv);
+	uint64_t mh = *pv & xh;
+
+	int hout = (ph & high) ? 1 : (mh & high) ? -1 : 0;
+
+	ph <<= 1;
+	mh <<= 1;
+	if (hin < 0)
+		mh |= 1;
+	else if (hin > 0)
+		ph |= 1;
+
+	*pv = mh | ~(xv | ph);
+	*mv = ph & xv;
+	return hout;
+}
+
+static Size myers_distance(Arena scratch, const Utf8 *x, Size m, const Utf8 *y, Size n)
+{
+	// The shorter string runs down the columns.
+	if (m > n) {
+		const Utf8 *t = x;  x = y;  y = t;
+		Size k = m;  m = n;  n = k;
+	}
+	if (m == 0)
+		return n;
+
+	Size words = (m + 63) / 64;
+	uint64_t *peq = alloc(&scratch, sizeof(uint64_t), _Alignof(uint64_t), 256 * words, ARENA_FILL_ZERO, CURRENT_LOCATION).data;
+	uint64_t *pv  = alloc(&scratch, sizeof(uint64_t), _Alignof(uint64_t), words, 0xFF, CURRENT_LOCATION).data;
+	uint64_t *mv  = alloc(&scratch, sizeof(uint64_t), _Alignof(uint64_t), words, ARENA_FILL_ZERO, CURRENT_LOCATION).data;
+
+	for (Size i = 0; i < m; ++i)
+		peq[x[i] * words + i / 64] |= 1ull << (i % 64);
+
+	uint64_t last_high = 1ull << ((m - 1) % 64);
+	Size score = m;
+
+	for (Size j = 0; j < n; ++j) {
+		const uint64_t *eq = &peq[y[j] * words];
+		int h = 1;
+		for (Size w = 0; w < words - 1; ++w)
+			h = myers_block(&pv[w], &mv[w], eq[w], h, 1ull << 63);
+		score += myers_block(&pv[words - 1], &mv[words - 1], eq[words - 1], h, last_high);
+	}
+
+	return score;
+}
+
+Size levenshtein(Arena *a, struct strand x, struct strand y)
+{
+	return myers_distance(*a, (const Utf8*)x.front, strand_length(x), (const Utf8*)y.front, strand_length(y));
+}
+
+Size levenshtein_String(Arena *a, String x, String y)
+{
+	return myers_distance(*a, x.data, x.length, y.data, y.length);
+}
+
+struct diff_context {
+	const struct strand *before, *after;
+	const uint64_t      *before_hash, *after_hash;
+	int                 *forward, *backward;
+	diff                 result;
+};
+
+static bool diff_same(const struct diff_context *c, int i, int j)
+{
+	return c->before_hash[i] == c->after_hash[j] && strand_equals(c->before[i], c->after[j]);
+}
+
+static void diff_emit(struct diff_context *c, enum diff_op op, int from, int to, int count)
+{
+	if (count == 0)
+		return;
+
+	diff_edit *last = c->result.count ? &c->result.edits[c->result.count - 1] : NULL;
+	if (last && last->op == op)
+		last->count += count;
+	else
+		c->result.edits[c->result.count++] = (diff_edit){ op, from, to, count };
+
+	if (op != DIFF_KEEP)
+		c->result.distance += count;
+}
+
+// Find where a shortest edit path between before[a0, a1) and after[b0, b1)
+// crosses its middle, by running forwards and backwards until the two
+// searches meet. Neither range may be empty or share a first or last
+// line with the other.
+static void diff_middle(const struct diff_context *c, int a0, int a1, int b0, int b1, int *split_a, int *split_b)
+{
+	int n = a1 - a0, m = b1 - b0;
+	int max_d = (n + m + 1) / 2;
+	int offset = max_d + 1;
+	int delta = n - m;
+	bool odd = delta & 1;
+	int *vf = c->forward, *vb = c->backward;
+
+	for (int k = 0; k < 2 * offset + 2; ++k)
+		vf[k] = vb[k] = -1;
+	vf[offset + 1] = vb[offset + 1] = 0;
+
+	for (int d = 0; d <= max_d; ++d) {
+		for (int k = -d; k <= d; k += 2) {
+			int x = (k == -d || (k != d && vf[offset+k-1] < vf[offset+k+1])) ? vf[offset+k+1] : vf[offset+k-1] + 1;
+			int y = x - k;
+			while (x < n && y < m && diff_same(c, a0 + x, b0 + y))
+				++x, ++y;
+			vf[offset + k] = x;
+
+			int rk = delta - k;
+			if (odd && -d < rk && rk < d && vb[offset + rk] >= 0 && x + vb[offset + rk] >= n) {
+				*split_a = a0 + x;
+				*split_b = b0 + y;
+				return;
+			}
+		}
+
+		for (int k = -d; k <= d; k += 2) {
+			int x = (k == -d || (k != d && vb[offset+k-1] < vb[offset+k+1])) ? vb[offset+k+1] : vb[offset+k-1] + 1;
+			int y = x - k;
+			while (x < n && y < m && diff_same(c, a1 - 1 - x, b1 - 1 - y))
+				++x, ++y;
+			vb[offset + k] = x;
+
+			int fk = delta - k;
+			if (!odd && -d <= fk && fk <= d && vf[offset + fk] >= 0 && vf[offset + fk] + x >= n) {
+				*split_a = a0 + vf[offset + fk];
+				*split_b = b0 + vf[offset + fk] - fk;
+				return;
+			}
+		}
+	}
+
+	// Not reached for non-empty ranges, but stay correct regardless.
+	*split_a = a1;
+	*split_b = b0;
+}
+
+static void diff_range(struct diff_context *c, int a0, int a1, int b0, int b1)
+{
+	int prefix = 0;
+	while (a0 + prefix < a1 && b0 + prefix < b1 && diff_same(c, a0 + prefix, b0 + prefix))
+		++prefix;
+	diff_emit(c, DIFF_KEEP, a0, b0, prefix);
+	a0 += prefix;
+	b0 += prefix;
+
+	int suffix = 0;
+	while (a0 < a1 - suffix && b0 < b1 - suffix && diff_same(c, a1 - 1 - suffix, b1 - 1 - suffix))
+		++suffix;
+	a1 -= suffix;
+	b1 -= suffix;
+
+	if (a0 == a1 || b0 == b1) {
+		diff_emit(c, DIFF_DELETE, a0, b0, a1 - a0);
+		diff_emit(c, DIFF_INSERT, a1, b0, b1 - b0);
+	}
+	else {
+		int split_a, split_b;
+		diff_middle(c, a0, a1, b0, b1, &split_a, &split_b);
+
+		if ((split_a == a0 && split_b == b0) || (split_a == a1 && split_b == b1)) {
+			diff_emit(c, DIFF_DELETE, a0, b0, a1 - a0);
+			diff_emit(c, DIFF_INSERT, a1, b0, b1 - b0);
+		}
+		else {
+			diff_range(c, a0, split_a, b0, split_b);
+			diff_range(c, split_a, a1, split_b, b1);
+		}
+	}
+
+	diff_emit(c, DIFF_KEEP, a1, b1, suffix);
+}
+
+diff diff_lines(Arena *a, const struct strand before[], int before_count, const struct strand after[], int after_count)
+{
+	struct diff_context c = { .before = before, .after = after };
+	c.result.edits = alloc(a, sizeof(diff_edit), _Alignof(diff_edit), before_count + after_count + 1, ARENA_NO_FILL, CURRENT_LOCATION).data;
+
+	// Hash each line once so most comparisons are one integer compare.
+	Arena scratch = *a;
+	Size v_size = before_count + after_count + 6;
+	uint64_t *before_hash = alloc(&scratch, sizeof(uint64_t), _Alignof(uint64_t), before_count, ARENA_NO_FILL, CURRENT_LOCATION).data;
+	uint64_t *after_hash = alloc(&scratch, sizeof(uint64_t), _Alignof(uint64_t), after_count, ARENA_NO_FILL, CURRENT_LOCATION).data;
+	c.forward  = alloc(&scratch, sizeof(int), _Alignof(int), v_size, ARENA_NO_FILL, CURRENT_LOCATION).data;
+	c.backward = alloc(&scratch, sizeof(int), _Alignof(int), v_size, ARENA_NO_FILL, CURRENT_LOCATION).data;
+
+	for (int i = 0; i < before_count; ++i)
+		before_hash[i] = hash(byte_span_init_n((const Byte*)before[i].front, strand_length(before[i])));
+	for (int j = 0; j < after_count; ++j)
+		after_hash[j] = hash(byte_span_init_n((const Byte*)after[j].front, strand_length(after[j])));
+	c.before_hash = before_hash;
+	c.after_hash = after_hash;
+
+	diff_range(&c, 0, before_count, 0, after_count);
+	return c.result;
+}
+
+
+struct link *link_next(struct link *n)
+{
+	return n ? n->next : NULL;
+}
+
+struct link *link_prev(struct link *n)
+{
+	return n ? n->prev : NULL;
+}
+
+_Bool link_is_attached(struct link *n)
+{
+	return n && (n->next || n->prev);
+}
+
+_Bool link_not_attached(struct link *n)
+{
+	return n && !n->next && !n->prev;
+}
+
+_Bool links_are_attached(struct link *l, struct link *r)
+{
+	return l && l->next == r && r && r->prev == l;
+}
+
+struct link *link_attach(struct link *a, struct link *b)
+{
+	if (a)  a->next = b;
+	if (b)  b->prev  = a;
+	return b;
+}
+
+void link_insert(struct link *new_link, struct link *before_this)
+{
+	link_attach(link_prev(before_this), new_link);
+	link_attach(new_link, before_this);
+}
+
+void link_append(struct link *after_this, struct link *new_link)
+{
+	link_attach(new_link, link_next(after_this));
+	link_attach(after_this, new_link);
+}
+
+void link_remove(struct link *n)
+{
+	link_attach(link_prev(n), link_next(n));
+	n->next = n->prev = NULL;
+}
+
+bool Chain_empty(const Chain * const chain)
+{
+	return !chain || chain->head.next == &chain->head;
+}
+
+struct link *Chain_first(Chain *chain)
+{
+	return Chain_empty(chain) ? NULL : chain->head.next;
+}
+
+struct link *Chain_last(Chain *chain)
+{
+	return Chain_empty(chain) ? NULL : chain->head.prev;
+}
+
+void  Chain_prepend(Chain *c, struct link *l)
+{
+	link_append(&c->head, l);
+}
+
+void Chain_append(Chain *c, struct link *l)
+{
+	link_insert(l, &c->head);
+}
+
+void Chain_appends(Chain *chain, ...)
+{
+	va_list args;
+	va_start(args, chain);
+
+	struct link *prev = &chain->head;
+	struct link *next = NULL;
+	while ((next = va_arg(args, struct link*)))
+		prev = link_attach(prev, next);
+	link_attach(prev, &chain->head);
+
+	va_end(args);
+}
+
+void *Chain_foreach(Chain *chain, void (*fn)(void*,void*), void *baggage, int offset)
+{
+	for (struct link *n = chain->head.next; n && n != &chain->head; n = n->next)
+		fn(baggage, (byte*)n + offset);
+	return baggage;
+}
+
+
+//----------------------------------------------------------------------
+//@module Logging
+//
+
+char *timestamp(char *s, size_t num, struct tm *(*totime)(const time_t*))
+{
+	time_t now = time(NULL);
+	strftime(s, num, "%Y-%m-%d %H.%M.%S %Z", totime(&now));
+	return s;
+}
+
+
+
+
+
+
+#define X(A,B,C)  {A,B,C},
+static const int XORSHIFT_PARAM_LIST[][3] = {
+	XORSHIFT_PARAMS
+};
+#undef X
+
+void Xorshift_init(Xorshifter *state, uint32_t seed, int params_num)
+{
+	params_num = params_num % ARRAY_SIZE(XORSHIFT_PARAM_LIST);
+    const int *params = XORSHIFT_PARAM_LIST[params_num];
+
+    *state = (Xorshifter)
+    { 
+        .a = params[0], 
+        .b = params[1], 
+        .c = params[2], 
+        .x = seed
+    };
+}
+
+uint32_t Xorshift_rand(Xorshifter *state)
+{
+	uint32_t x = state->x;
+	x ^= x << state->a;
+	x ^= x >> state->b;
+	x ^= x << state->c;
+	return state->x = x;
+}
+
+uint64_t hash_fnv_1a_64bit(struct byte_span data, uint64_t hash)
+{
+	const uint64_t fnv_1a_64bit_prime = 0x100000001B3;
+
+	const byte *end = data.back;
+	for (const byte *b = data.front; b != end; ++b) {
+		hash ^= (uint64_t)*b;
+		hash *= fnv_1a_64bit_prime;
+	}
+
+	return hash;
 }
 
 uint64_t hash(struct byte_span data)
@@ -461,4 +4407,19 @@ uint64_t hash(struct byte_span data)
 	return hash_fnv_1a_64bit(data, fnv_1a_64bit_offset_basis);
 }
 
+uint64_t hash_nocase(struct strand s)
+{
+	uint64_t h = 14695981039346656037llu;
+	byte folded[8];
+
+	for (const char *p = s.front; p < s.back; p += sizeof(folded)) {
+		int n = int_min(s.back - p, sizeof(folded));
+		memcpy(folded, p, n);
+		ascii_to_lower((char*)folded, n);
+		h = hash_fnv_1a_64bit(byte_span_init_n(folded, n), h);
+	}
+
+	return h;
+}
+
 
@@ -3,7 +3,9 @@
 
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdarg.h>
 #include <stdint.h>
+#include <stdatomic.h>
 #include <time.h>
 #include <setjmp.h>
 
@@ -55,6 +57,56 @@ DEFINE_DECONST_FUNC(double, fl)
 DEFINE_DECONST_FUNC(bool, bool)
 DEFINE_DECONST_FUNC(size_t, size_t)
 
+
+// Bit counts of a 64-bit word, using the compiler builtins where there
+// are any. Zero has 64 leading and 64 trailing zeros.
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(__TINYC__)
+#  define KR_BIT_BUILTINS  1
+#else
+#  define KR_BIT_BUILTINS  0
+#endif
+
+static inline int uint64_popcount(uint64_t w)
+{
+#if KR_BIT_BUILTINS
+	return __builtin_popcountll(w);
+#else
+	w -= (w >> 1) & 0x5555555555555555ull;
+	w = (w & 0x3333333333333333ull) + ((w >> 2) & 0x3333333333333333ull);
+	w = (w + (w >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+	return (int)((w * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+static inline int uint64_trailing_zeros(uint64_t w)
+{
+	if (w == 0)
+		return 64;
+#if KR_BIT_BUILTINS
+	return __builtin_ctzll(w);
+#else
+	return uint64_popcount((w & -w) - 1);
+#endif
+}
+
+static inline int uint64_leading_zeros(uint64_t w)
+{
+	if (w == 0)
+		return 64;
+#if KR_BIT_BUILTINS
+	return __builtin_clzll(w);
+#else
+	int z = 0;
+	for (int shift = 32; shift > 0; shift /= 2) {
+		if (!(w >> (64 - shift))) {
+			z += shift;
+			w <<= shift;
+		}
+	}
+	return z;
+#endif
+}
+
 //----------------------------------------------------------------------
 //@module Debugging & Error Checking
 
@@ -114,6 +166,7 @@ void debug_set_volume(enum debug_level level);
             X(MATH_OVERFLOW,    "Arithmetic overflow") \
 			X(MALLOC_FAIL,      "Memory allocation failed") \
 			X(OUT_OF_SPACE,     "Not enough space to copy data") \
+			X(IO_FAILURE,       "Input/output failed") \
 			X(EXCEPTION,        "Exception thrown") 
 
 #define X(EnumName_, _)  STATUS_##EnumName_,
@@ -174,6 +227,9 @@ bool size_t_add_overflows(size_t a, size_t b);
 size_t try_size_mult(size_t a, size_t b, struct except_frame *xf, struct SourceLocation loc);
 size_t try_size_add(size_t a, size_t b, struct except_frame *xf, struct SourceLocation loc);
 
+bool uint64_mult_overflows(uint64_t a, uint64_t b);
+bool uint64_add_overflows(uint64_t a, uint64_t b);
+
 bool   int_mult_overflows(int a, int b);
 int    try_int_mult(int a, int b, struct except_frame *xf, struct SourceLocation loc);
 
@@ -249,6 +305,43 @@ struct strand strand_trim_back(struct strand s, int (*istype)(int));
 struct strand strand_trim_front(struct strand s, int (*istype)(int));
 struct strand strand_trim(struct strand s, int (*istype)(int));
 
+// ASCII case-insensitive comparison. Bytes outside A-Z, including UTF-8
+// sequences, must match exactly. Eight bytes are folded at a time.
+bool   strand_equals_nocase(struct strand a, struct strand b);
+int    strand_compare_nocase(struct strand a, struct strand b);
+
+// Fold ASCII letters in place, leaving every other byte alone.
+void   ascii_to_lower(char *s, int n);
+void   ascii_to_upper(char *s, int n);
+
+static inline struct strand String_strand(String s)
+{
+	return strand_init_n((const char*)s.data, s.length);
+}
+
+// Split iterator. Fields are views into the original strand, nothing is
+// allocated. Adjacent separators yield empty fields.
+//
+// Use:
+//      struct strand field;
+//      for (strand_splitter it = strand_split_char(line, ',');
+//           strand_split_next(&it, &field); )
+//          ...
+//
+typedef struct strand_splitter {
+	struct strand rest;
+	enum { SPLIT_CHAR, SPLIT_ANY, SPLIT_SUBSTR } by;
+	bool          done;
+	char          sep_char;
+	struct strand sep_str;
+	uint8_t       sep_set[256/8];
+} strand_splitter;
+
+strand_splitter strand_split_char(struct strand s, char sep);
+strand_splitter strand_split_any(struct strand s, struct strand seps);
+strand_splitter strand_split_str(struct strand s, struct strand sep);
+bool            strand_split_next(strand_splitter *it, struct strand *field);
+
 
 //----------------------------------------------------------------------
 //@module strbuf
@@ -276,6 +369,286 @@ static inline int strbuf_cap(const struct strbuf *buf)
 }
 
 char *strbuf_end(strbuf buf);
+enum status   strbuf_cat(struct strbuf *buf, struct strand str);
+struct strand strbuf_strand(struct strbuf buf);
+
+// Format into the unused space of buf, always leaving it NUL-terminated.
+// Returns STATUS_OUT_OF_SPACE if the output was truncated to fit.
+enum status   strbuf_printf(struct strbuf *buf, const char *format, ...);
+enum status   strbuf_vprintf(struct strbuf *buf, const char *format, va_list args);
+
+// Join parts with sep between them. The total size is computed first, so
+// on STATUS_OUT_OF_SPACE nothing is written.
+enum status   strbuf_join(struct strbuf *buf, const struct strand parts[], int count, struct strand sep);
+struct strand strand_join(Arena *a, const struct strand parts[], int count, struct strand sep);
+enum status   strbuf_cat_lower(struct strbuf *buf, struct strand str);
+
+
+//----------------------------------------------------------------------
+//@module Number formatting
+//
+// Integers are written two digits at a time from a digit-pair table.
+// Doubles are written in the shortest form that reads back to the same
+// value (Grisu2), plain for 1e-7 < |d| < 1e21 and as 1.5e-9 otherwise.
+// Each function writes a NUL-terminated string and returns its length.
+
+#define INT_STR_SIZE     NUM_STR_LEN(int64_t)
+#define DOUBLE_STR_SIZE  32
+
+int uint32_to_str(char *out, uint32_t n);
+int int32_to_str(char *out, int32_t n);
+int uint64_to_str(char *out, uint64_t n);
+int int64_to_str(char *out, int64_t n);
+int double_to_str(char *out, double d);
+
+enum status strbuf_put_int(struct strbuf *buf, int64_t n);
+enum status strbuf_put_uint(struct strbuf *buf, uint64_t n);
+enum status strbuf_put_double(struct strbuf *buf, double d);
+
+
+//----------------------------------------------------------------------
+//@module Number parsing
+//
+// Parse a number from the front of a strand. No NUL terminator is needed
+// and the locale is ignored. Returns STATUS_ERROR if there are no digits,
+// or STATUS_MATH_OVERFLOW if the number doesn't fit, leaving *value
+// unchanged. *used, if not NULL, gets the number of chars parsed.
+// Signed parsers accept a leading + or -; no whitespace is skipped.
+
+enum status parse_uint64(struct strand s, uint64_t *value, int *used);
+enum status parse_uint32(struct strand s, uint32_t *value, int *used);
+enum status parse_uint16(struct strand s, uint16_t *value, int *used);
+enum status parse_uint8(struct strand s, uint8_t *value, int *used);
+enum status parse_int64(struct strand s, int64_t *value, int *used);
+enum status parse_int32(struct strand s, int32_t *value, int *used);
+enum status parse_int16(struct strand s, int16_t *value, int *used);
+enum status parse_int8(struct strand s, int8_t *value, int *used);
+
+// Correctly rounded. Also accepts inf, infinity and nan in any case.
+// On overflow *value is set to +/-inf.
+enum status parse_double(struct strand s, double *value, int *used);
+
+
+//----------------------------------------------------------------------
+//@module writer - Buffered output sink
+//
+// Gathers output in a caller-supplied strbuf and hands it to the file
+// descriptor with one write(2) when full, or one writev(2) when a large
+// append would overflow the buffer. Errors are sticky: after the first
+// failure every append is a no-op and writer_flush() reports the status.
+//
+// Use:
+//      writer out = WRITER_INIT(STDOUT_FILENO, (char[1<<16]){});
+//      writer_puts(&out, STR("Hello"));
+//      writer_flush(&out);
+//
+
+typedef struct writer {
+	strbuf       buf;
+	int          fd;
+	enum status  status;
+} writer;
+
+static inline writer writer_init(int fd, char *buf, size_t size)
+{
+	return (writer){ .buf = strbuf_init(buf, size), .fd = fd, .status = STATUS_OK };
+}
+
+#define WRITER_INIT(FD_, BUF_)  writer_init((FD_), (BUF_), sizeof(BUF_))
+
+enum status writer_flush(writer *w);
+enum status writer_write(writer *w, const void *data, size_t n);
+void        writer_puts(writer *w, struct strand str);
+void        writer_put_String(writer *w, String s);
+void        writer_put_int(writer *w, long long n);
+void        writer_put_uint(writer *w, unsigned long long n);
+void        writer_put_double(writer *w, double d);
+
+static inline void writer_putc(writer *w, int c)
+{
+	if (strbuf_cap(&w->buf) > 0  &&  w->status == STATUS_OK)
+		*w->buf.back++ = c;
+	else
+		writer_write(w, &(char){ c }, 1);
+}
+
+
+//----------------------------------------------------------------------
+//@module rope - Immutable string tree for large concatenations
+//
+// Leaves are String pieces, interior nodes are concatenations. Nodes
+// live in an Arena and are never modified, so ropes share structure
+// freely. Concatenation keeps the tree AVL-balanced, making concat,
+// slice and indexing O(log n). Short leaves are merged into Arena chunks
+// so appending many small pieces doesn't grow one node per piece.
+// A NULL rope is the empty rope.
+
+typedef struct rope {
+	Size               length;
+	int                depth;
+	const struct rope *left, *right;   // NULL for leaves
+	String             leaf;
+} rope;
+
+// Leaves no longer than this are copied together when concatenated.
+#define ROPE_SHORT_LEAF  64
+
+const rope *rope_String(Arena *a, String s);
+const rope *rope_strand(Arena *a, struct strand s);
+const rope *rope_concat(Arena *a, const rope *left, const rope *right);
+const rope *rope_slice(Arena *a, const rope *r, Size from, Size to);
+int         rope_at(const rope *r, Size i);
+String      rope_flatten(Arena *a, const rope *r);
+enum status rope_write(const rope *r, int fd);
+
+static inline Size rope_length(const rope *r)
+{
+	return r ? r->length : 0;
+}
+
+static inline int rope_depth(const rope *r)
+{
+	return r ? r->depth : -1;
+}
+
+
+//----------------------------------------------------------------------
+//@module utf8 - Validate, decode and encode UTF-8
+//
+// Validation follows the Unicode well-formed byte sequence table, so
+// overlong forms, surrogates and code points above U+10FFFF are
+// rejected. ASCII runs are skipped eight bytes at a time.
+
+enum {
+	UTF8_INVALID = -1,
+	UTF8_MAX_LEN = 4,
+};
+
+Size    utf8_invalid_at(String s);
+bool    utf8_is_valid(String s);
+Size    utf8_count(String s);
+Size    utf8_offset(String s, Size n);
+int32_t utf8_next(String *s);
+int     utf8_encode(int32_t cp, Utf8 out[UTF8_MAX_LEN]);
+enum status strbuf_put_utf8(struct strbuf *buf, int32_t cp);
+
+static inline bool utf8_is_continuation(Utf8 b)
+{
+	return (b & 0xC0) == 0x80;
+}
+
+
+//----------------------------------------------------------------------
+//@module ac - Aho-Corasick multi-pattern matching
+//
+// Compiles a set of patterns into a DFA that finds every occurrence of
+// every pattern, overlaps included, in one pass over the text. Bytes that
+// appear in no pattern share one column of the transition table, so a
+// state's row is only as wide as the pattern alphabet. Everything lives
+// in the Arena passed to ac_compile().
+//
+// A scanner reports matches in order of where they end; matches ending
+// at the same byte come longest first. Text can be fed in chunks, with
+// match offsets counted from the start of the whole stream.
+
+typedef struct ac_matcher {
+	int            patterns;
+	int            states;
+	int            classes;
+	uint16_t       byte_class[256];   // 0 for bytes in no pattern, so up to 257 classes
+	const int32_t *next;      // [states][classes]
+	const int32_t *output;    // nearest state with a pattern, this one included, or 0
+	const int32_t *suffix;    // output of the failure state
+	const int32_t *first;     // first pattern ending at a state, or -1
+	const int32_t *same;      // next pattern with identical text, or -1
+	const int32_t *length;    // pattern lengths
+} ac_matcher;
+
+typedef struct ac_match {
+	int  pattern;             // index into the compiled patterns
+	Size start, end;          // [start, end) in the stream
+} ac_match;
+
+typedef struct ac_scanner {
+	const ac_matcher *ac;
+	const uint8_t    *front, *back;   // unscanned part of the current chunk
+	Size              offset;         // stream offset of front
+	int32_t           state;
+	int32_t           hit;            // state whose patterns are being reported
+	int32_t           pattern;        // next pattern to report, or -1
+} ac_scanner;
+
+const ac_matcher *ac_compile(Arena *a, const struct strand patterns[], int count);
+bool        ac_contains(const ac_matcher *ac, struct strand text);
+ac_scanner  ac_scan(const ac_matcher *ac, struct strand text);
+void        ac_feed(ac_scanner *scan, struct strand chunk);
+bool        ac_next(ac_scanner *scan, ac_match *match);
+
+
+//----------------------------------------------------------------------
+//@module regex - Regular expressions and globs matched by a lazy DFA
+//
+// Patterns compile to a Thompson NFA whose DFA states are built on
+// demand and cached, so matching is linear in the text and never
+// backtracks. Bytes no pattern set tells apart share a DFA column.
+// Everything, the state cache included, lives in the Arena passed to
+// the compiler; when the cache fills it is flushed and rebuilt as
+// needed. Matching updates the cache, so a regex must not be used by
+// two threads at once.
+//
+// Syntax: literals, . (any byte but newline), [a-z] and [^a-z] classes,
+// \d \w \s and their negations, \n \r \t, \ before punctuation, the
+// postfix operators * + ?, | and ( ). ^ and $ anchor the whole pattern
+// and are only allowed at its ends. Matching is byte-wise.
+//
+// Globs support * (any run of bytes), ? (any byte), [...] and [!...]
+// classes and \ escapes, and always match the whole text.
+
+typedef struct regex regex;
+
+enum status regex_compile(Arena *a, struct strand pattern, regex **re);
+enum status glob_compile(Arena *a, struct strand pattern, regex **re);
+
+// Does the whole text match?
+bool        regex_match(regex *re, struct strand text);
+
+// Does some part of the text match? Stops at the first match found.
+bool        regex_search(regex *re, struct strand text);
+
+// Find the leftmost, then longest, match.
+bool        regex_find(regex *re, struct strand text, struct strand *found);
+
+
+//----------------------------------------------------------------------
+//@module diff - Edit distance and line diff
+//
+// levenshtein() is Myers' bit-vector algorithm, computing a column of
+// the edit distance table 64 cells per word op, in O(n * m/64) time.
+// diff_lines() is Myers' O(ND) diff in its linear space, middle snake
+// form. Both use the Arena for scratch space and give it back; the
+// diff edits stay in the Arena.
+
+Size levenshtein(Arena *a, struct strand x, struct strand y);
+Size levenshtein_String(Arena *a, String x, String y);
+
+enum diff_op { DIFF_KEEP, DIFF_DELETE, DIFF_INSERT };
+
+// A run of count lines kept or deleted from before[from] onward, or
+// inserted from after[to] onward. from and to are where the run sits in
+// both inputs.
+typedef struct diff_edit {
+	enum diff_op op;
+	int          from, to;
+	int          count;
+} diff_edit;
+
+typedef struct diff {
+	diff_edit *edits;
+	int        count;
+	int        distance;   // lines deleted plus lines inserted
+} diff;
+
+diff diff_lines(Arena *a, const struct strand before[], int before_count, const struct strand after[], int after_count);
 
 
 //----------------------------------------------------------------------
@@ -340,13 +713,22 @@ char *timestamp(char *s, size_t num, struct tm *(*totime)(const time_t*));
 
 //@module List - Dynamic Resizeable Arrays
 
-typedef struct { int cap, length; } ListDims;
+typedef struct { Size cap, length; } ListDims;
 
 #define LIST(EL_TYPE)  struct { ListDims head; EL_TYPE front[]; }
 
 #define LIST_BASE(L_)  ((ListDims*)L_)
 
-void *List_grow(void *a, int sizeof_base, int sizeof_item, int min_cap, int add_length);
+// Lists that run out of room grow by this percentage of their capacity,
+// 200 by default. 100 grows them to exactly the length needed.
+// LIST_RESERVE always reserves exactly the capacity asked for. The
+// setting is process-wide and unsynchronised; set it before any threads
+// start growing lists.
+void  List_set_growth(int percent);
+
+// Sizes are overflow checked and allocation failure is fatal.
+void *List_grow(void *a, Size sizeof_base, Size sizeof_item, Size min_cap, Size add_length);
+void *List_shrink(void *a, Size sizeof_base, Size sizeof_item);
 
 #define LIST_GROW(L_, CAP_, ADD_)     \
 	do{ (L_) = List_grow(             \
@@ -363,18 +745,22 @@ void *List_grow(void *a, int sizeof_base, int sizeof_item, int min_cap, int add_
 #define LIST_RESERVE(L_, NEW_CAP_)     \
 	LIST_GROW(L_, NEW_CAP_, 0)
 
+// Release unused capacity. An empty list is freed and becomes NULL.
+#define LIST_SHRINK_TO_FIT(L_)  \
+	do{ (L_) = List_shrink((L_), sizeof(*(L_)), sizeof(*(L_)->front)); }while(0)
+
 #define LIST_PUSH(L_, VAL_) \
 	do{ \
 		LIST_ADD(L_, 1); \
 		(L_)->front[(L_)->head.length-1] = (VAL_); \
 	}while(0)
 
-static inline int List_capacity(void *l)
+static inline Size List_capacity(void *l)
 {
 	return l? ((ListDims*)l)->cap: 0;
 }
 
-static inline int List_length(void *l)
+static inline Size List_length(void *l)
 {
 	return l? ((ListDims*)l)->length: 0;
 }
@@ -389,16 +775,29 @@ static inline bool List_is_empty(void *l)
 	return List_length(l) == 0;
 }
 
-static inline bool List_in_bounds(void *l, int i)
+static inline bool List_in_bounds(void *l, Size i)
 {
 	return l && LIST_BASE(l)->length > i;
 }
 
-static inline int List_check(void *l, int i)
+// Bounds checks on list indexing are on in DEBUG builds. Define
+// LIST_CHECKED as 0 or 1 before including this header to choose.
+#ifndef LIST_CHECKED
+#  ifdef DEBUG
+#    define LIST_CHECKED  1
+#  else
+#    define LIST_CHECKED  0
+#  endif
+#endif
+
+void List_bounds_failure(Size i, Size length, struct SourceLocation loc);
+
+static inline Size List_check(void *l, Size i)
 {
 	if (i < 0)
-		i = LIST_BASE(l)->length + i;
-//	CHECK(l && List_in_bounds(l, i));
+		i = List_length(l) + i;
+	if (LIST_CHECKED && (i < 0 || !List_in_bounds(l, i)))
+		List_bounds_failure(i, List_length(l), CURRENT_LOCATION);
 	return i;
 }
 
@@ -407,6 +806,125 @@ static inline int List_check(void *l, int i)
 
 void List_dispose(void *l);
 
+// Bulk operations reserve at most once and move elements with memmove.
+// Indexes must be in [0, length], ranges inside the list. Inserted items
+// may come from the list itself, e.g. LIST_APPEND_SPAN(l, LIST_SPAN(...)).
+void *List_insert(void *l, Size sizeof_base, Size sizeof_item, Size at, const void *items, Size count);
+void  List_erase(void *l, Size sizeof_base, Size sizeof_item, Size at, Size count);
+void  List_swap_remove(void *l, Size sizeof_base, Size sizeof_item, Size i);
+void *List_resize(void *l, Size sizeof_base, Size sizeof_item, Size length, bool zero_fill);
+
+#define LIST_INSERT_N(L_, AT_, ITEMS_, N_)  \
+	do{ (L_) = List_insert((L_), sizeof(*(L_)), sizeof(*(L_)->front), (AT_), (ITEMS_), (N_)); }while(0)
+
+#define LIST_APPEND_N(L_, ITEMS_, N_)  \
+	LIST_INSERT_N(L_, List_length(L_), ITEMS_, N_)
+
+// Append every element of a span, e.g. an int_span to a LIST(int).
+#define LIST_APPEND_SPAN(L_, SPAN_)  \
+	LIST_APPEND_N(L_, (SPAN_).front, (SPAN_).back - (SPAN_).front)
+
+#define LIST_ERASE(L_, AT_, N_)  \
+	List_erase((L_), sizeof(*(L_)), sizeof(*(L_)->front), (AT_), (N_))
+
+// Remove element I_ in O(1) by moving the last element into its place.
+#define LIST_SWAP_REMOVE(L_, I_)  \
+	List_swap_remove((L_), sizeof(*(L_)), sizeof(*(L_)->front), (I_))
+
+// Set the length, zeroing any new elements or, with _UNINIT, leaving
+// them for the caller to fill.
+#define LIST_RESIZE(L_, N_)  \
+	do{ (L_) = List_resize((L_), sizeof(*(L_)), sizeof(*(L_)->front), (N_), true); }while(0)
+
+#define LIST_RESIZE_UNINIT(L_, N_)  \
+	do{ (L_) = List_resize((L_), sizeof(*(L_)), sizeof(*(L_)->front), (N_), false); }while(0)
+
+#define LIST_TRUNCATE(L_, N_)  \
+	do{ if (List_length(L_) > (N_))  (L_)->head.length = (N_); }while(0)
+
+// View the elements as a span, e.g. LIST_SPAN(l, int_span). The span
+// is invalidated by anything that may reallocate the list.
+#define LIST_SPAN(L_, SPAN_NAME_)  \
+	((L_) ? (struct SPAN_NAME_){ (L_)->front, (L_)->front + (L_)->head.length } : (struct SPAN_NAME_){0})
+
+// Typed lists: LIST_TEMPLATE(int, int_list) defines struct int_list,
+// laid out like LIST(int), and static inline int_list_push, _pop, _at,
+// _last, _reserve, _length, _capacity and _dispose. Element sizes are
+// constants and push only calls List_grow when the list is full.
+// Functions that may reallocate return the list, which may have moved.
+// _at and _pop are bounds checked when LIST_CHECKED is on.
+
+#define LIST_TEMPLATE(Type_, Name_)  \
+	struct Name_ { ListDims head; Type_ front[]; }; \
+	static inline Size CONCAT(Name_,_length)(const struct Name_ *l) { \
+		return l ? l->head.length : 0; } \
+	static inline Size CONCAT(Name_,_capacity)(const struct Name_ *l) { \
+		return l ? l->head.cap : 0; } \
+	static inline struct Name_ *CONCAT(Name_,_reserve)(struct Name_ *l, Size cap) { \
+		return List_grow(l, sizeof(struct Name_), sizeof(Type_), cap, 0); } \
+	static inline struct Name_ *CONCAT(Name_,_push)(struct Name_ *l, Type_ value) { \
+		if (l && l->head.length < l->head.cap) { \
+			l->front[l->head.length++] = value; \
+			return l; } \
+		l = List_grow(l, sizeof(struct Name_), sizeof(Type_), 0, 1); \
+		l->front[l->head.length - 1] = value; \
+		return l; } \
+	static inline Type_ *CONCAT(Name_,_at)(struct Name_ *l, Size i) { \
+		if (LIST_CHECKED && !(0 <= i && i < CONCAT(Name_,_length)(l))) \
+			List_bounds_failure(i, CONCAT(Name_,_length)(l), CURRENT_LOCATION); \
+		return &l->front[i]; } \
+	static inline Type_ *CONCAT(Name_,_last)(struct Name_ *l) { \
+		return CONCAT(Name_,_at)(l, CONCAT(Name_,_length)(l) - 1); } \
+	static inline Type_ CONCAT(Name_,_pop)(struct Name_ *l) { \
+		Type_ value = *CONCAT(Name_,_last)(l); \
+		--l->head.length; \
+		return value; } \
+	static inline void CONCAT(Name_,_dispose)(struct Name_ *l) { \
+		List_dispose(l); }
+
+
+
+
+
+// Small lists keep up to N_ elements inline, in the struct itself, and
+// move them to the heap only when they outgrow that. A zeroed small list
+// is empty. The macros take a pointer to the small list and mirror the
+// LIST ones; List_length() and List_capacity() work on it too.
+#define SMALL_LIST(T_, N_)  struct { ListDims head; union { T_ local[N_]; T_ *heap; }; }
+
+#define SMALL_LIST_LOCAL_CAP(L_)  (Size)(sizeof((L_)->local) / sizeof((L_)->local[0]))
+
+#define SMALL_LIST_IS_LOCAL(L_)   ((L_)->head.cap <= SMALL_LIST_LOCAL_CAP(L_))
+
+#define SMALL_LIST_FRONT(L_)      (SMALL_LIST_IS_LOCAL(L_) ? (L_)->local : (L_)->heap)
+
+void SmallList_grow(ListDims *head, void *storage, Size local_cap, Size sizeof_item, Size min_cap, Size add_length);
+void SmallList_append(ListDims *head, void *storage, Size local_cap, Size sizeof_item, const void *items, Size count);
+
+#define SMALL_LIST_GROW(L_, CAP_, ADD_)  \
+	SmallList_grow(&(L_)->head, (L_)->local, SMALL_LIST_LOCAL_CAP(L_), sizeof((L_)->local[0]), (CAP_), (ADD_))
+
+#define SMALL_LIST_ADD(L_, ADD_SIZE_)     SMALL_LIST_GROW(L_, 0, ADD_SIZE_)
+#define SMALL_LIST_RESERVE(L_, NEW_CAP_)  SMALL_LIST_GROW(L_, NEW_CAP_, 0)
+
+#define SMALL_LIST_PUSH(L_, VAL_)  \
+	do{ \
+		SMALL_LIST_ADD(L_, 1); \
+		SMALL_LIST_FRONT(L_)[(L_)->head.length-1] = (VAL_); \
+	}while(0)
+
+// ITEMS_ may be the small list's own elements, as with LIST_INSERT_N.
+#define SMALL_LIST_APPEND_N(L_, ITEMS_, N_)  \
+	SmallList_append(&(L_)->head, (L_)->local, SMALL_LIST_LOCAL_CAP(L_), sizeof((L_)->local[0]), (ITEMS_), (N_))
+
+#define SMALL_LIST_AT(L_, I_)  (SMALL_LIST_FRONT(L_)[List_check((L_), (I_))])
+#define SMALL_LIST_LAST(L_)    SMALL_LIST_AT(L_, -1)
+
+#define SMALL_LIST_DISPOSE(L_)  \
+	do{ \
+		if (!SMALL_LIST_IS_LOCAL(L_))  free((L_)->heap); \
+		(L_)->head = (ListDims){0}; \
+	}while(0)
 
 
 
@@ -414,6 +932,582 @@ void List_dispose(void *l);
 void sum_ints(void *total, void *next_i);
 
 
+//----------------------------------------------------------------------
+//@module slot_map - Dense storage addressed by generational handles
+//
+// Elements are packed in a dense array for cache-linear iteration,
+// while handles go through a slot table that follows them as they
+// move. Each slot has a generation that changes when its element is
+// erased, so stale handles are detected rather than reaching whichever
+// element reused the slot. Insert and erase are O(1); erase moves the
+// last element into the hole, so element pointers and dense order are
+// not stable, but handles are.
+
+typedef struct slot_handle {
+	uint32_t index;
+	uint32_t generation;     // never 0 for a live element
+} slot_handle;
+
+struct slot_entry {
+	uint32_t dense;          // element index, or next free slot
+	uint32_t generation;
+};
+
+typedef struct slot_map {
+	Size      item_size;
+	void     *dense;         // list of item_size elements
+	LIST(uint32_t)          *dense_slot;   // slot of each element
+	LIST(struct slot_entry) *slots;
+	uint32_t  free_slot;     // head of the free list, or SLOT_MAP_NONE
+} slot_map;
+
+#define SLOT_MAP_NONE  UINT32_MAX
+
+#define SLOT_MAP_INIT(T_)  (slot_map){ .item_size = sizeof(T_), .free_slot = SLOT_MAP_NONE }
+
+slot_handle slot_map_insert(slot_map *m, const void *item);
+bool        slot_map_erase(slot_map *m, slot_handle h);
+void       *slot_map_get(const slot_map *m, slot_handle h);
+void        slot_map_clear(slot_map *m);
+void        slot_map_dispose(slot_map *m);
+
+// Iterate over live elements: for i in [0, count), slot_map_at(m, i).
+Size        slot_map_count(const slot_map *m);
+void       *slot_map_at(const slot_map *m, Size i);
+slot_handle slot_map_handle_at(const slot_map *m, Size i);
+
+static inline bool slot_map_contains(const slot_map *m, slot_handle h)
+{
+	return slot_map_get(m, h) != NULL;
+}
+
+
+//----------------------------------------------------------------------
+//@module Queue - Lock-free bounded queues between threads
+//
+// SPSC_QUEUE_TEMPLATE(int, int_spsc) defines a single-producer,
+// single-consumer ring. Each side keeps a cached copy of the other's
+// index and only reads the shared one when the cache says the queue is
+// full or empty, so most operations touch no shared cache line.
+//
+// MPMC_QUEUE_TEMPLATE(int, int_mpmc) defines Dmitry Vyukov's bounded
+// multi-producer, multi-consumer queue. Each cell has a sequence number
+// telling producers and consumers whose turn it is, so claiming a cell
+// is one compare-and-swap on the shared position.
+//
+// Both have _init (capacity rounded up to a power of two), _dispose,
+// non-blocking _try_push and _try_pop, and _push_n and _pop_n, which move
+// as many items as they can at once and return how many. Indexes owned
+// by different threads are kept on separate cache lines.
+
+#define CACHE_LINE_SIZE  64
+
+void *Queue_alloc(Size *cap, Size sizeof_item);
+void  Queue_free(void *items);
+
+#define SPSC_QUEUE_TEMPLATE(Type_, Name_)  \
+	struct Name_ { \
+		Type_         *items; \
+		size_t         mask; \
+		char           pad0[CACHE_LINE_SIZE]; \
+		atomic_size_t  head;          /* next to pop, written by the consumer */ \
+		size_t         cached_tail; \
+		char           pad1[CACHE_LINE_SIZE]; \
+		atomic_size_t  tail;          /* next to push, written by the producer */ \
+		size_t         cached_head; \
+		char           pad2[CACHE_LINE_SIZE]; \
+	}; \
+	static inline enum status CONCAT(Name_,_init)(struct Name_ *q, Size cap) { \
+		*q = (struct Name_){0}; \
+		if (!(q->items = Queue_alloc(&cap, sizeof(Type_)))) \
+			return STATUS_MALLOC_FAIL; \
+		q->mask = cap - 1; \
+		atomic_init(&q->head, 0); \
+		atomic_init(&q->tail, 0); \
+		return STATUS_OK; } \
+	static inline void CONCAT(Name_,_dispose)(struct Name_ *q) { \
+		Queue_free(q->items); \
+		q->items = NULL; } \
+	/* Room for up to want more items, as seen by the producer. */ \
+	static inline size_t CONCAT(Name_,_room)(struct Name_ *q, size_t tail, size_t want) { \
+		size_t room = q->mask + 1 - (tail - q->cached_head); \
+		if (room < want) { \
+			q->cached_head = atomic_load_explicit(&q->head, memory_order_acquire); \
+			room = q->mask + 1 - (tail - q->cached_head); } \
+		return room < want ? room : want; } \
+	/* Items ready, up to want, as seen by the consumer. */ \
+	static inline size_t CONCAT(Name_,_ready)(struct Name_ *q, size_t head, size_t want) { \
+		size_t ready = q->cached_tail - head; \
+		if (ready < want) { \
+			q->cached_tail = atomic_load_explicit(&q->tail, memory_order_acquire); \
+			ready = q->cached_tail - head; } \
+		return ready < want ? ready : want; } \
+	static inline bool CONCAT(Name_,_try_push)(struct Name_ *q, Type_ value) { \
+		size_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed); \
+		if (!CONCAT(Name_,_room)(q, tail, 1)) \
+			return false; \
+		q->items[tail & q->mask] = value; \
+		atomic_store_explicit(&q->tail, tail + 1, memory_order_release); \
+		return true; } \
+	static inline bool CONCAT(Name_,_try_pop)(struct Name_ *q, Type_ *value) { \
+		size_t head = atomic_load_explicit(&q->head, memory_order_relaxed); \
+		if (!CONCAT(Name_,_ready)(q, head, 1)) \
+			return false; \
+		*value = q->items[head & q->mask]; \
+		atomic_store_explicit(&q->head, head + 1, memory_order_release); \
+		return true; } \
+	static inline Size CONCAT(Name_,_push_n)(struct Name_ *q, const Type_ *src, Size count) { \
+		size_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed); \
+		size_t n = CONCAT(Name_,_room)(q, tail, count); \
+		for (size_t i = 0; i < n; ++i) \
+			q->items[(tail + i) & q->mask] = src[i]; \
+		atomic_store_explicit(&q->tail, tail + n, memory_order_release); \
+		return n; } \
+	static inline Size CONCAT(Name_,_pop_n)(struct Name_ *q, Type_ *dst, Size count) { \
+		size_t head = atomic_load_explicit(&q->head, memory_order_relaxed); \
+		size_t n = CONCAT(Name_,_ready)(q, head, count); \
+		for (size_t i = 0; i < n; ++i) \
+			dst[i] = q->items[(head + i) & q->mask]; \
+		atomic_store_explicit(&q->head, head + n, memory_order_release); \
+		return n; }
+
+#define MPMC_QUEUE_TEMPLATE(Type_, Name_)  \
+	struct CONCAT(Name_,_cell) { \
+		atomic_size_t  sequence; \
+		Type_          value; \
+	}; \
+	struct Name_ { \
+		struct CONCAT(Name_,_cell) *cells; \
+		size_t         mask; \
+		char           pad0[CACHE_LINE_SIZE]; \
+		atomic_size_t  enqueue_pos; \
+		char           pad1[CACHE_LINE_SIZE]; \
+		atomic_size_t  dequeue_pos; \
+		char           pad2[CACHE_LINE_SIZE]; \
+	}; \
+	static inline enum status CONCAT(Name_,_init)(struct Name_ *q, Size cap) { \
+		*q = (struct Name_){0}; \
+		if (!(q->cells = Queue_alloc(&cap, sizeof(struct CONCAT(Name_,_cell))))) \
+			return STATUS_MALLOC_FAIL; \
+		q->mask = cap - 1; \
+		for (Size i = 0; i < cap; ++i) \
+			atomic_init(&q->cells[i].sequence, i); \
+		atomic_init(&q->enqueue_pos, 0); \
+		atomic_init(&q->dequeue_pos, 0); \
+		return STATUS_OK; } \
+	static inline void CONCAT(Name_,_dispose)(struct Name_ *q) { \
+		Queue_free(q->cells); \
+		q->cells = NULL; } \
+	/* Claim up to want cells from *pos on whose sequence is pos + lag, */ \
+	/* lag being 0 for free cells and 1 for filled ones. */ \
+	static inline size_t CONCAT(Name_,_claim)(struct Name_ *q, atomic_size_t *at, size_t *pos, size_t want, size_t lag) { \
+		*pos = atomic_load_explicit(at, memory_order_relaxed); \
+		if (want == 0) \
+			return 0; \
+		for (;;) { \
+			size_t n = 0; \
+			intptr_t dif = 0; \
+			for (; n < want && n <= q->mask; ++n) { \
+				size_t seq = atomic_load_explicit(&q->cells[(*pos + n) & q->mask].sequence, memory_order_acquire); \
+				if ((dif = (intptr_t)(seq - (*pos + n + lag))) != 0) \
+					break; } \
+			if (n > 0) { \
+				if (atomic_compare_exchange_weak_explicit(at, pos, *pos + n, memory_order_relaxed, memory_order_relaxed)) \
+					return n; } \
+			else if (dif < 0) \
+				return 0;       /* full, or empty */ \
+			else \
+				*pos = atomic_load_explicit(at, memory_order_relaxed); } } \
+	static inline Size CONCAT(Name_,_push_n)(struct Name_ *q, const Type_ *src, Size count) { \
+		size_t pos, n = CONCAT(Name_,_claim)(q, &q->enqueue_pos, &pos, count, 0); \
+		for (size_t i = 0; i < n; ++i) { \
+			struct CONCAT(Name_,_cell) *cell = &q->cells[(pos + i) & q->mask]; \
+			cell->value = src[i]; \
+			atomic_store_explicit(&cell->sequence, pos + i + 1, memory_order_release); } \
+		return n; } \
+	static inline Size CONCAT(Name_,_pop_n)(struct Name_ *q, Type_ *dst, Size count) { \
+		size_t pos, n = CONCAT(Name_,_claim)(q, &q->dequeue_pos, &pos, count, 1); \
+		for (size_t i = 0; i < n; ++i) { \
+			struct CONCAT(Name_,_cell) *cell = &q->cells[(pos + i) & q->mask]; \
+			dst[i] = cell->value; \
+			atomic_store_explicit(&cell->sequence, pos + i + q->mask + 1, memory_order_release); } \
+		return n; } \
+	static inline bool CONCAT(Name_,_try_push)(struct Name_ *q, Type_ value) { \
+		return CONCAT(Name_,_push_n)(q, &value, 1) == 1; } \
+	static inline bool CONCAT(Name_,_try_pop)(struct Name_ *q, Type_ *value) { \
+		return CONCAT(Name_,_pop_n)(q, value, 1) == 1; }
+
+
+//----------------------------------------------------------------------
+//@module Ring - Deques and fixed-size ring buffers
+//
+// DEQUE_TEMPLATE(int, int_deque) defines a growable double-ended queue
+// struct int_deque, zeroed when empty, with static inline functions
+// int_deque_push_back, _push_front, _pop_back, _pop_front, _at, _write,
+// _read, _reserve, _length, _is_empty, _clear and _dispose.
+// RING_TEMPLATE(int, int_ring, 64) defines a ring of at most 64 items
+// stored inline, whose _push and _write report when it is full.
+//
+// Capacities are powers of two so positions wrap with a mask. _at takes
+// negative indexes from the back and is bounds checked when LIST_CHECKED
+// is on. _write appends and _read removes from the front in at most two
+// memcpys each.
+
+void *Ring_grow(void *items, Size sizeof_item, Size *cap, Size head, Size length, Size min_cap);
+void  Ring_copy_in(void *items, Size sizeof_item, Size cap, Size at, const void *src, Size count);
+void  Ring_copy_out(const void *items, Size sizeof_item, Size cap, Size at, void *dst, Size count);
+void  Ring_dispose(void *items);
+
+static inline Size Ring_check(Size i, Size length)
+{
+	if (i < 0)
+		i += length;
+	if (LIST_CHECKED && !(0 <= i && i < length))
+		List_bounds_failure(i, length, CURRENT_LOCATION);
+	return i;
+}
+
+#define DEQUE_TEMPLATE(Type_, Name_)  \
+	struct Name_ { Type_ *items; Size cap, head, length; }; \
+	static inline Size CONCAT(Name_,_length)(const struct Name_ *d) { \
+		return d->length; } \
+	static inline bool CONCAT(Name_,_is_empty)(const struct Name_ *d) { \
+		return d->length == 0; } \
+	static inline void CONCAT(Name_,_reserve)(struct Name_ *d, Size cap) { \
+		if (cap > d->cap) { \
+			d->items = Ring_grow(d->items, sizeof(Type_), &d->cap, d->head, d->length, cap); \
+			d->head = 0; } } \
+	static inline Type_ *CONCAT(Name_,_at)(struct Name_ *d, Size i) { \
+		return &d->items[(d->head + Ring_check(i, d->length)) & (d->cap - 1)]; } \
+	static inline void CONCAT(Name_,_push_back)(struct Name_ *d, Type_ value) { \
+		if (d->length == d->cap) \
+			CONCAT(Name_,_reserve)(d, d->length + 1); \
+		d->items[(d->head + d->length++) & (d->cap - 1)] = value; } \
+	static inline void CONCAT(Name_,_push_front)(struct Name_ *d, Type_ value) { \
+		if (d->length == d->cap) \
+			CONCAT(Name_,_reserve)(d, d->length + 1); \
+		d->head = (d->head - 1) & (d->cap - 1); \
+		d->items[d->head] = value; \
+		++d->length; } \
+	static inline Type_ CONCAT(Name_,_pop_front)(struct Name_ *d) { \
+		Type_ value = *CONCAT(Name_,_at)(d, 0); \
+		d->head = (d->head + 1) & (d->cap - 1); \
+		--d->length; \
+		return value; } \
+	static inline Type_ CONCAT(Name_,_pop_back)(struct Name_ *d) { \
+		Type_ value = *CONCAT(Name_,_at)(d, -1); \
+		--d->length; \
+		return value; } \
+	static inline void CONCAT(Name_,_write)(struct Name_ *d, const Type_ *src, Size count) { \
+		CONCAT(Name_,_reserve)(d, d->length + count); \
+		Ring_copy_in(d->items, sizeof(Type_), d->cap, (d->head + d->length) & (d->cap - 1), src, count); \
+		d->length += count; } \
+	static inline Size CONCAT(Name_,_read)(struct Name_ *d, Type_ *dst, Size count) { \
+		if (count > d->length)  count = d->length; \
+		Ring_copy_out(d->items, sizeof(Type_), d->cap, d->head, dst, count); \
+		d->head = (d->head + count) & (d->cap - 1); \
+		d->length -= count; \
+		return count; } \
+	static inline void CONCAT(Name_,_clear)(struct Name_ *d) { \
+		d->head = d->length = 0; } \
+	static inline void CONCAT(Name_,_dispose)(struct Name_ *d) { \
+		Ring_dispose(d->items); \
+		*d = (struct Name_){0}; }
+
+#define RING_TEMPLATE(Type_, Name_, N_)  \
+	_Static_assert((N_) > 0 && ((N_) & ((N_) - 1)) == 0, "ring size must be a power of two"); \
+	struct Name_ { Size head, length; Type_ items[N_]; }; \
+	static inline Size CONCAT(Name_,_length)(const struct Name_ *r) { \
+		return r->length; } \
+	static inline bool CONCAT(Name_,_is_empty)(const struct Name_ *r) { \
+		return r->length == 0; } \
+	static inline bool CONCAT(Name_,_is_full)(const struct Name_ *r) { \
+		return r->length == (N_); } \
+	static inline Type_ *CONCAT(Name_,_at)(struct Name_ *r, Size i) { \
+		return &r->items[(r->head + Ring_check(i, r->length)) & ((N_) - 1)]; } \
+	static inline bool CONCAT(Name_,_push)(struct Name_ *r, Type_ value) { \
+		if (r->length == (N_)) \
+			return false; \
+		r->items[(r->head + r->length++) & ((N_) - 1)] = value; \
+		return true; } \
+	static inline bool CONCAT(Name_,_pop)(struct Name_ *r, Type_ *value) { \
+		if (r->length == 0) \
+			return false; \
+		*value = r->items[r->head]; \
+		r->head = (r->head + 1) & ((N_) - 1); \
+		--r->length; \
+		return true; } \
+	static inline Size CONCAT(Name_,_write)(struct Name_ *r, const Type_ *src, Size count) { \
+		if (count > (N_) - r->length)  count = (N_) - r->length; \
+		Ring_copy_in(r->items, sizeof(Type_), (N_), (r->head + r->length) & ((N_) - 1), src, count); \
+		r->length += count; \
+		return count; } \
+	static inline Size CONCAT(Name_,_read)(struct Name_ *r, Type_ *dst, Size count) { \
+		if (count > r->length)  count = r->length; \
+		Ring_copy_out(r->items, sizeof(Type_), (N_), r->head, dst, count); \
+		r->head = (r->head + count) & ((N_) - 1); \
+		r->length -= count; \
+		return count; }
+
+
+//@module Heap - Priority queues
+//
+// HEAP_TEMPLATE(struct job, job_heap, job_before) defines struct job_heap,
+// zeroed when empty, ordered so that _top is an element no other element
+// is job_before. Less_(a, b) compares two values and may be a function or
+// a macro. The static inline functions are job_heap_push, _pop, _top,
+// _heapify, _length, _is_empty, _clear and _dispose.
+//
+// The heap is 4-ary: the children of i are 4i+1 to 4i+4. It is half as
+// deep as a binary heap and the four children share a cache line or two,
+// which pays for the extra comparisons when sifting down.
+//
+// Elements pushed with _push_id carry a caller chosen id, a small index
+// such as a node number. _contains, _decrease, _update and _top_id find
+// them through an id to position map, which costs nothing until first
+// used. _decrease requires the new value not to sort after the old one;
+// _update, and _push_id of a queued id, move it either way.
+
+#define HEAP_ARITY  4
+
+#define HEAP_TEMPLATE(Type_, Name_, Less_)  \
+	struct Name_ { LIST(Type_) *items; LIST(Size) *ids, *pos; }; \
+	static inline Size CONCAT(Name_,_length)(const struct Name_ *h) { \
+		return List_length(h->items); } \
+	static inline bool CONCAT(Name_,_is_empty)(const struct Name_ *h) { \
+		return List_length(h->items) == 0; } \
+	static inline Size CONCAT(Name_,_id_at)(const struct Name_ *h, Size i) { \
+		return h->pos ? h->ids->front[i] : -1; } \
+	static inline void CONCAT(Name_,_place)(struct Name_ *h, Size i, Type_ value, Size id) { \
+		h->items->front[i] = value; \
+		if (h->pos) { \
+			h->ids->front[i] = id; \
+			if (id >= 0)  h->pos->front[id] = i; } } \
+	static inline void CONCAT(Name_,_sift_up)(struct Name_ *h, Size i, Type_ value, Size id) { \
+		while (i > 0) { \
+			Size parent = (i - 1) / HEAP_ARITY; \
+			if (!(Less_(value, h->items->front[parent]))) \
+				break; \
+			CONCAT(Name_,_place)(h, i, h->items->front[parent], CONCAT(Name_,_id_at)(h, parent)); \
+			i = parent; } \
+		CONCAT(Name_,_place)(h, i, value, id); } \
+	static inline void CONCAT(Name_,_sift_down)(struct Name_ *h, Size i, Type_ value, Size id) { \
+		Size n = List_length(h->items); \
+		for (Size first; (first = i * HEAP_ARITY + 1) < n; ) { \
+			Size end = (n - first > HEAP_ARITY) ? first + HEAP_ARITY : n; \
+			Size best = first; \
+			for (Size c = first + 1; c < end; ++c) \
+				if (Less_(h->items->front[c], h->items->front[best])) \
+					best = c; \
+			if (!(Less_(h->items->front[best], value))) \
+				break; \
+			CONCAT(Name_,_place)(h, i, h->items->front[best], CONCAT(Name_,_id_at)(h, best)); \
+			i = best; } \
+		CONCAT(Name_,_place)(h, i, value, id); } \
+	static inline Type_ *CONCAT(Name_,_top)(struct Name_ *h) { \
+		if (LIST_CHECKED && CONCAT(Name_,_is_empty)(h)) \
+			List_bounds_failure(0, 0, CURRENT_LOCATION); \
+		return &h->items->front[0]; } \
+	static inline Size CONCAT(Name_,_top_id)(struct Name_ *h) { \
+		CONCAT(Name_,_top)(h); \
+		return CONCAT(Name_,_id_at)(h, 0); } \
+	static inline void CONCAT(Name_,_push)(struct Name_ *h, Type_ value) { \
+		LIST_ADD(h->items, 1); \
+		if (h->pos)  LIST_ADD(h->ids, 1); \
+		CONCAT(Name_,_sift_up)(h, List_length(h->items) - 1, value, -1); } \
+	static inline Type_ CONCAT(Name_,_pop)(struct Name_ *h) { \
+		Type_ top = *CONCAT(Name_,_top)(h); \
+		Size top_id = CONCAT(Name_,_id_at)(h, 0); \
+		Size n = --h->items->head.length; \
+		if (h->pos) { \
+			--h->ids->head.length; \
+			if (top_id >= 0)  h->pos->front[top_id] = -1; } \
+		if (n > 0) \
+			CONCAT(Name_,_sift_down)(h, 0, h->items->front[n], CONCAT(Name_,_id_at)(h, n)); \
+		return top; } \
+	static inline void CONCAT(Name_,_heapify)(struct Name_ *h, const Type_ *items, Size count) { \
+		Size old = List_length(h->items); \
+		LIST_APPEND_N(h->items, items, count); \
+		if (h->pos) { \
+			LIST_RESIZE_UNINIT(h->ids, old + count); \
+			for (Size i = old; i < old + count; ++i)  h->ids->front[i] = -1; } \
+		Size n = List_length(h->items); \
+		for (Size i = (n > 1) ? (n - 2) / HEAP_ARITY + 1 : 0; i-- > 0; ) \
+			CONCAT(Name_,_sift_down)(h, i, h->items->front[i], CONCAT(Name_,_id_at)(h, i)); } \
+	static inline bool CONCAT(Name_,_contains)(const struct Name_ *h, Size id) { \
+		return h->pos && 0 <= id && id < List_length(h->pos) && h->pos->front[id] >= 0; } \
+	static inline void CONCAT(Name_,_decrease)(struct Name_ *h, Size id, Type_ value) { \
+		REQUIRE(CONCAT(Name_,_contains)(h, id)); \
+		REQUIRE(!(Less_(h->items->front[h->pos->front[id]], value))); \
+		CONCAT(Name_,_sift_up)(h, h->pos->front[id], value, id); } \
+	static inline void CONCAT(Name_,_update)(struct Name_ *h, Size id, Type_ value) { \
+		REQUIRE(CONCAT(Name_,_contains)(h, id)); \
+		Size i = h->pos->front[id]; \
+		if (Less_(h->items->front[i], value)) \
+			CONCAT(Name_,_sift_down)(h, i, value, id); \
+		else \
+			CONCAT(Name_,_sift_up)(h, i, value, id); } \
+	static inline void CONCAT(Name_,_push_id)(struct Name_ *h, Size id, Type_ value) { \
+		REQUIRE(id >= 0); \
+		if (CONCAT(Name_,_contains)(h, id)) { \
+			CONCAT(Name_,_update)(h, id, value); \
+			return; } \
+		if (!h->pos) { \
+			LIST_RESIZE_UNINIT(h->ids, List_length(h->items)); \
+			for (Size i = 0; i < List_length(h->items); ++i)  h->ids->front[i] = -1; } \
+		Size known = List_length(h->pos); \
+		if (id >= known) { \
+			LIST_RESIZE_UNINIT(h->pos, id + 1); \
+			for (Size i = known; i <= id; ++i)  h->pos->front[i] = -1; } \
+		LIST_ADD(h->items, 1); \
+		LIST_ADD(h->ids, 1); \
+		CONCAT(Name_,_sift_up)(h, List_length(h->items) - 1, value, id); } \
+	static inline void CONCAT(Name_,_clear)(struct Name_ *h) { \
+		if (h->items)  h->items->head.length = 0; \
+		if (h->ids)  h->ids->head.length = 0; \
+		for (Size i = 0; i < List_length(h->pos); ++i)  h->pos->front[i] = -1; } \
+	static inline void CONCAT(Name_,_dispose)(struct Name_ *h) { \
+		List_dispose(h->items); \
+		List_dispose(h->ids); \
+		List_dispose(h->pos); \
+		*h = (struct Name_){0}; }
+
+
+//@module bitset - Packed sets of small integers
+//
+// A bitset holds one bit for each index in [0, length), 64 to a word, so
+// a visited set over a grid is an eighth the size of a bool array. Bits
+// past the length in the last word are always clear. bitset_alloc()
+// takes the words from an Arena; bitset_create() takes them from the heap,
+// where they can be resized and must be disposed. Both start all clear.
+//
+// bitset_and, _or, _xor and _andnot combine two bitsets of the same
+// length into the first, one word at a time in loops plain enough for
+// the compiler to vectorize, so their words must not overlap. Indexes
+// are bounds checked when LIST_CHECKED is on.
+
+#define BITSET_WORD_BITS  64
+#define BITSET_WORDS(Length_)  (((Length_) + BITSET_WORD_BITS - 1) / BITSET_WORD_BITS)
+
+struct bitset { uint64_t *words; Size length; };
+
+struct bitset bitset_alloc(Arena *a, Size length);
+struct bitset bitset_create(Size length);
+void          bitset_resize(struct bitset *b, Size length);
+void          bitset_dispose(struct bitset *b);
+
+void bitset_fill(struct bitset *b, bool value);
+Size bitset_count(struct bitset b);
+bool bitset_is_empty(struct bitset b);
+bool bitset_equals(struct bitset a, struct bitset b);
+
+// The first set (or clear) index at or after from, or -1 if there is none.
+Size bitset_next_set(struct bitset b, Size from);
+Size bitset_next_clear(struct bitset b, Size from);
+
+void bitset_and(struct bitset *dst, struct bitset src);
+void bitset_or(struct bitset *dst, struct bitset src);
+void bitset_xor(struct bitset *dst, struct bitset src);
+void bitset_andnot(struct bitset *dst, struct bitset src);
+
+static inline Size bitset_check(struct bitset b, Size i)
+{
+	if (LIST_CHECKED && !(0 <= i && i < b.length))
+		List_bounds_failure(i, b.length, CURRENT_LOCATION);
+	return i;
+}
+
+static inline bool bitset_test(struct bitset b, Size i)
+{
+	bitset_check(b, i);
+	return (b.words[i / BITSET_WORD_BITS] >> (i % BITSET_WORD_BITS)) & 1;
+}
+
+static inline void bitset_set(struct bitset *b, Size i)
+{
+	bitset_check(*b, i);
+	b->words[i / BITSET_WORD_BITS] |= 1ull << (i % BITSET_WORD_BITS);
+}
+
+static inline void bitset_clear(struct bitset *b, Size i)
+{
+	bitset_check(*b, i);
+	b->words[i / BITSET_WORD_BITS] &= ~(1ull << (i % BITSET_WORD_BITS));
+}
+
+// Set bit i and report whether it was already set, as for visited sets.
+static inline bool bitset_test_and_set(struct bitset *b, Size i)
+{
+	bool was_set = bitset_test(*b, i);
+	b->words[i / BITSET_WORD_BITS] |= 1ull << (i % BITSET_WORD_BITS);
+	return was_set;
+}
+
+
+//@module bitrank - Rank and select over a bitset
+//
+// bitrank_build() indexes a bitset, which must not change afterwards, in
+// about a quarter of its size again. Bits are grouped into blocks of 512,
+// eight words, and each block has a pair of interleaved counts: the set
+// bits before the block, and the set bits before each of its words packed
+// nine bits apiece. A rank is then two loads and a popcount.
+//
+// Select samples the block holding every 512th set (and clear) bit,
+// searches the blocks between two samples, then the counts in the block,
+// then the word.
+
+#define BITRANK_BLOCK_BITS   512
+#define BITRANK_SAMPLE_RATE  512
+
+struct bitrank
+{
+	struct bitset  bits;
+	uint64_t      *counts;      // absolute, relative pairs per block
+	uint32_t      *samples1;    // block of every SAMPLE_RATEth set bit
+	uint32_t      *samples0;    // and clear bit
+	Size           blocks, ones;
+};
+
+struct bitrank bitrank_build(Arena *a, struct bitset bits);
+
+// Set (or clear) bits in [0, i), for i in [0, length].
+Size bitrank_rank(const struct bitrank *r, Size i);
+Size bitrank_rank0(const struct bitrank *r, Size i);
+
+// Index of the kth set (or clear) bit counting from 0, or -1 if there
+// are not that many.
+Size bitrank_select(const struct bitrank *r, Size k);
+Size bitrank_select0(const struct bitrank *r, Size k);
+
+
+//@module elias_fano - Compressed sorted integer sequences
+//
+// Elias-Fano stores n sorted values below u in about 2 + log2(u/n) bits
+// each, close to the least possible, and still allows random access.
+// The low bits of each value are packed verbatim; the high bits are
+// written in unary into a bitset with a bitrank index, so the ith value's
+// high bits are select(i) - i.
+
+struct elias_fano
+{
+	struct bitrank  high;
+	uint64_t       *low;
+	int             low_bits;
+	Size            count;
+};
+
+// values must be in non-decreasing order.
+struct elias_fano elias_fano_build(Arena *a, const uint64_t values[], Size count);
+
+uint64_t elias_fano_get(const struct elias_fano *ef, Size i);
+
+// Index of the first value not less than x, or the count if none is.
+Size elias_fano_lower_bound(const struct elias_fano *ef, uint64_t x);
+
+// Bits used by the encoding and its index.
+Size elias_fano_bits(const struct elias_fano *ef);
+
+
 //@module Pseudo-Random Number Generation
 
 #define XORSHIFT_TEMPLATE(X_, A_, B_, C_)  \
@@ -533,6 +1627,9 @@ uint64_t hash_fnv_1a_64bit(struct byte_span data, uint64_t hash);
 
 uint64_t hash(struct byte_span data);
 
+// Same as hash() of the ASCII lowercase copy of s.
+uint64_t hash_nocase(struct strand s);
+
 //@module Fibonacci Sequence Iterator
 
 typedef struct Fibonacci_struct {
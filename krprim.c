@@ -56,7 +56,7 @@ void String_fprint(String s, FILE *out)
 {
 	assert(s.data && s.length);
 	assert(out);
-	while (s.length--)  fputc(*s.data++, out); 
+	fwrite(s.data, 1, s.length, out);
 }
 
 String String_slice(String str, int from, int to) 
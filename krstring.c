@@ -1,10 +1,15 @@
 #include <string.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 
 #include "krstring.h"
 #include "krclib.h"
 
+// Strings are reference counted. A string with more than one reference
+// is immutable: functions that modify it copy it first and return the
+// copy, leaving the other references untouched.
 typedef struct string {
+	atomic_size_t refs;
 	size_t size;
 	char  *back;
 	char   front[];
@@ -23,41 +28,154 @@ string *string_create(const char *from)
 
 void string_dispose(string *s)
 {
-	free(s);
+	if (s && atomic_fetch_sub_explicit(&s->refs, 1, memory_order_acq_rel) == 1)
+		free(s);
+}
+
+string *string_share(string *s)
+{
+	if (s)  atomic_fetch_add_explicit(&s->refs, 1, memory_order_relaxed);
+	return s;
+}
+
+bool string_is_shared(const string *s)
+{
+	return s && atomic_load_explicit(&s->refs, memory_order_acquire) > 1;
+}
+
+string *string_copy(const string *from)
+{
+	if (!from)
+		return NULL;
+
+	string *s = string_reserve(NULL, from->size);
+	memcpy(s->front, from->front, from->size);
+	s->back = s->front + string_length(from);
+	return s;
+}
+
+static enum string_growth string_growth = STRING_GROW_DOUBLE;
+
+void string_set_growth(enum string_growth growth)
+{
+	string_growth = growth;
+}
+
+// New size for a string of size bytes that must hold at least needed.
+static size_t string_grow_size(size_t size, size_t needed)
+{
+	switch (string_growth) {
+		case STRING_GROW_EXACT:   break;
+		case STRING_GROW_HALF:    size += size / 2;  break;
+		case STRING_GROW_DOUBLE:  size *= 2;  break;
+	}
+	return size_max(size, needed);
 }
 
 string *string_reserve(string *s, size_t bigger)
 {
+	bool shared = string_is_shared(s);
+
 	if (s && bigger == 0)
-		bigger = s->size * 2;
+		bigger = string_grow_size(s->size, s->size + 1);
 
-	else if (s && s->size >= bigger)
+	else if (s && s->size >= bigger && !shared)
 		return s;
 
+	bigger = size_max(bigger, string_size(s));
 	bigger = size_max(bigger, 8);
 
 	size_t length = string_length(s);
-	string *new_s = realloc(s, sizeof(string) + bigger);
+	string *new_s = realloc(shared ? NULL : s, sizeof(string) + bigger);
 	
 	if (!new_s) {
 		fprintf(stderr, "string_reserve() failed to allocate %zu bytes.\n", bigger);
 		exit(1);
 	}
 
+	if (shared) {
+		memcpy(new_s->front, s->front, s->size);
+		string_dispose(s);
+	}
+
+	if (shared || !s)
+		atomic_init(&new_s->refs, 1);
+
 	new_s->size = bigger;
 	new_s->back = new_s->front + length;
 
 	return new_s;
 }
 
+// Take a private copy of a shared string before writing to it.
+static string *string_unshare(string *s)
+{
+	return string_is_shared(s) ? string_reserve(s, s->size) : s;
+}
+
 string *string_pushc(string *s, int c)
 {
 	if (string_is_full(s))
 		s = string_reserve(s, 0);
+	else
+		s = string_unshare(s);
 	*s->back++ = c;
 	return s;
 }
 
+// Replace len chars at index at with n bytes from data, growing the
+// string at most once. data may point into s itself; those bytes can be
+// moved by growing and overwritten by the replacement, so they are
+// copied aside first.
+string *string_replace(string *s, size_t at, size_t len, const char *data, size_t n)
+{
+	size_t length = string_length(s);
+	REQUIRE(at <= length  &&  len <= length - at);
+
+	char small[256], *copy = NULL;
+	uintptr_t front = s ? (uintptr_t)s->front : 0, from = (uintptr_t)data;
+	if (n && s && front <= from && from < front + s->size) {
+		copy = (n <= sizeof(small)) ? small : try_malloc(n, NULL, CURRENT_LOCATION);
+		data = memcpy(copy, data, n);
+	}
+
+	size_t new_length = length - len + n;
+	if (new_length + 1 > string_size(s))
+		s = string_reserve(s, string_grow_size(string_size(s), new_length + 1));
+	else
+		s = string_unshare(s);
+
+	memmove(s->front + at + n, s->front + at + len, length - at - len);
+	if (n)
+		memcpy(s->front + at, data, n);
+	s->back = s->front + new_length;
+	*s->back = '\0';
+
+	if (copy && copy != small)
+		free(copy);
+	return s;
+}
+
+string *string_insert(string *s, size_t at, const char *data, size_t n)
+{
+	return string_replace(s, at, 0, data, n);
+}
+
+string *string_append(string *s, const char *data, size_t n)
+{
+	return string_replace(s, string_length(s), 0, data, n);
+}
+
+string *string_append_strand(string *s, struct strand str)
+{
+	return string_append(s, str.front, strand_length(str));
+}
+
+string *string_append_String(string *s, String str)
+{
+	return string_append(s, (const char*)str.data, str.length);
+}
+
 
 
 size_t string_length(const string *s)
@@ -101,19 +219,29 @@ void string_puts(const string *s)
 
 
 
+// Most formatted strings are short, so format once into a stack buffer
+// and only run vsnprintf a second time when the result doesn't fit.
+#define STRING_FORMAT_STACK_SIZE  256
+
 string *string_format(const char *format, ...)
 {
+	char stack_buf[STRING_FORMAT_STACK_SIZE];
+
 	va_list args;
 	va_start(args, format);
 
 	va_list n_args;
 	va_copy(n_args, args);
-	int length = vsnprintf(NULL, 0, format, n_args) + 1;
+	int length = vsnprintf(stack_buf, sizeof(stack_buf), format, n_args);
 	va_end(n_args);
 
-	string *s = string_reserve(NULL, length + 1);
-	if (s && s->size > 1) {
-		vsnprintf(ch_deconst(s->front), s->size, format, args);
+	string *s = NULL;
+	if (length >= 0) {
+		s = string_reserve(NULL, length + 1);
+		if (length < (int)sizeof(stack_buf))
+			memcpy(s->front, stack_buf, length + 1);
+		else
+			vsnprintf(s->front, s->size, format, args);
 		s->back = s->front + length;
 	}
 
@@ -123,6 +251,7 @@ string *string_format(const char *format, ...)
 
 string *string_clear(string *s)
 {
+	s = string_unshare(s);
 	if (s)  s->back = s->front;
 	return s;
 }
@@ -132,7 +261,7 @@ string *string_fgetline(FILE *in, string *s)
 	if (feof(in))
 		return NULL;
 
-	if (s)  s->back = s->front;
+	s = string_clear(s);
 
 	int c;
 	while ((c = fgetc(in)) != EOF && c != '\n')
@@ -150,3 +279,266 @@ void string_swap(string **a, string **b)
 	*b = t;
 }
 
+
+
+//----------------------------------------------------------------------
+// Small string
+
+#define SSTRING_TAG(S_)  ((unsigned char*)(S_)->local)[SSTRING_LOCAL_SIZE-1]
+
+static char *sstring_front(sstring *s)
+{
+	return sstring_is_local(s) ? s->local : s->heap->front;
+}
+
+static void sstring_set_length(sstring *s, size_t length)
+{
+	if (sstring_is_local(s))
+		SSTRING_TAG(s) = length;
+	else
+		s->heap->back = s->heap->front + length;
+	sstring_front(s)[length] = '\0';
+}
+
+sstring sstring_create(const char *from)
+{
+	size_t length = strlen(from);
+	sstring s = {0};
+
+	if (length <= SSTRING_LOCAL_CAP) {
+		memcpy(s.local, from, length + 1);
+		SSTRING_TAG(&s) = length;
+	}
+	else {
+		s.heap = string_create(from);
+		SSTRING_TAG(&s) = SSTRING_ON_HEAP;
+	}
+
+	return s;
+}
+
+void sstring_reserve(sstring *s, size_t bigger)
+{
+	if (!sstring_is_local(s)) {
+		s->heap = string_reserve(s->heap, bigger);
+		return;
+	}
+
+	if (bigger == 0)
+		bigger = sstring_size(s) * 2;
+	else if (bigger <= sstring_size(s))
+		return;
+
+	size_t length = SSTRING_TAG(s);
+	string *heap = string_reserve(NULL, bigger);
+	memcpy(heap->front, s->local, length + 1);
+	heap->back = heap->front + length;
+
+	s->heap = heap;
+	SSTRING_TAG(s) = SSTRING_ON_HEAP;
+}
+
+void sstring_pushc(sstring *s, int c)
+{
+	if (sstring_is_full(s))
+		sstring_reserve(s, 0);
+
+	size_t length = sstring_length(s);
+	sstring_front(s)[length] = c;
+	sstring_set_length(s, length + 1);
+}
+
+void sstring_dispose(sstring *s)
+{
+	if (s && !sstring_is_local(s))
+		string_dispose(s->heap);
+	if (s)
+		*s = (sstring){0};
+}
+
+size_t sstring_length(const sstring *s)
+{
+	if (!s)  return 0;
+	return sstring_is_local(s) ? SSTRING_TAG(s) : string_length(s->heap);
+}
+
+size_t sstring_size(const sstring *s)
+{
+	if (!s)  return 0;
+	return sstring_is_local(s) ? SSTRING_LOCAL_SIZE - 1 : string_size(s->heap);
+}
+
+bool sstring_is_local(const sstring *s)
+{
+	return SSTRING_TAG(s) != SSTRING_ON_HEAP;
+}
+
+bool sstring_is_full(const sstring *s)
+{
+	// Keep room for the NUL terminator.
+	return sstring_length(s) + 1 >= sstring_size(s);
+}
+
+bool sstring_is_empty(const sstring *s)
+{
+	return sstring_length(s) == 0;
+}
+
+const char *sstring_cstr(const sstring *s)
+{
+	if (!s)  return "";
+	return sstring_is_local(s) ? s->local : string_cstr(s->heap);
+}
+
+bool sstring_equals(const sstring *s, const char *cstr)
+{
+	if (s && cstr)
+		return !strcmp(sstring_cstr(s), cstr);
+	else
+		return (!s && !cstr);
+}
+
+void sstring_clear(sstring *s)
+{
+	if (s)  sstring_set_length(s, 0);
+}
+
+
+
+//----------------------------------------------------------------------
+// Gap string
+
+// Chars [0, gap_front) come before the cursor and [gap_back, size)
+// after it. The gap is kept as offsets so realloc needn't fix pointers.
+typedef struct gapstring {
+	size_t size;
+	size_t gap_front;
+	size_t gap_back;
+	char   front[];
+} gapstring;
+
+gapstring *gapstring_create(const char *from)
+{
+	return gapstring_insert(NULL, from, strlen(from));
+}
+
+gapstring *gapstring_reserve(gapstring *g, size_t bigger)
+{
+	if (g && bigger <= g->size)
+		return g;
+
+	bigger = size_max(bigger, 8);
+
+	size_t size = gapstring_size(g);
+	size_t after = g ? size - g->gap_back : 0;
+	gapstring *new_g = realloc(g, sizeof(gapstring) + bigger);
+
+	if (!new_g) {
+		fprintf(stderr, "gapstring_reserve() failed to allocate %zu bytes.\n", bigger);
+		exit(1);
+	}
+
+	if (!g)
+		new_g->gap_front = 0;
+
+	// Keep the text after the gap at the end of the bigger allocation.
+	memmove(new_g->front + bigger - after, new_g->front + size - after, after);
+	new_g->gap_back = bigger - after;
+	new_g->size = bigger;
+
+	return new_g;
+}
+
+gapstring *gapstring_insert(gapstring *g, const char *data, size_t n)
+{
+	size_t needed = gapstring_length(g) + n;
+	if (!g || needed > gapstring_size(g))
+		g = gapstring_reserve(g, string_grow_size(gapstring_size(g), needed));
+
+	memcpy(g->front + g->gap_front, data, n);
+	g->gap_front += n;
+	return g;
+}
+
+gapstring *gapstring_pushc(gapstring *g, int c)
+{
+	char ch = c;
+	return gapstring_insert(g, &ch, 1);
+}
+
+void gapstring_dispose(gapstring *g)
+{
+	free(g);
+}
+
+void gapstring_delete_before(gapstring *g, size_t n)
+{
+	REQUIRE(n <= gapstring_cursor(g));
+	if (g)  g->gap_front -= n;
+}
+
+void gapstring_delete_after(gapstring *g, size_t n)
+{
+	REQUIRE(n <= gapstring_length(g) - gapstring_cursor(g));
+	if (g)  g->gap_back += n;
+}
+
+void gapstring_move_to(gapstring *g, size_t at)
+{
+	REQUIRE(at <= gapstring_length(g));
+	if (!g)
+		return;
+
+	if (at < g->gap_front) {
+		size_t n = g->gap_front - at;
+		memmove(g->front + g->gap_back - n, g->front + at, n);
+		g->gap_front -= n;
+		g->gap_back -= n;
+	}
+	else if (at > g->gap_front) {
+		size_t n = at - g->gap_front;
+		memmove(g->front + g->gap_front, g->front + g->gap_back, n);
+		g->gap_front += n;
+		g->gap_back += n;
+	}
+}
+
+void gapstring_move_by(gapstring *g, ptrdiff_t delta)
+{
+	gapstring_move_to(g, gapstring_cursor(g) + delta);
+}
+
+size_t gapstring_cursor(const gapstring *g)
+{
+	return g ? g->gap_front : 0;
+}
+
+size_t gapstring_length(const gapstring *g)
+{
+	return g ? g->gap_front + (g->size - g->gap_back) : 0;
+}
+
+size_t gapstring_size(const gapstring *g)
+{
+	return g ? g->size : 0;
+}
+
+gapstring_view gapstring_strands(const gapstring *g)
+{
+	if (!g)
+		return (gapstring_view){0};
+
+	return (gapstring_view){
+		.before = strand_init_n(g->front, g->gap_front),
+		.after  = strand_init_n(g->front + g->gap_back, g->size - g->gap_back),
+	};
+}
+
+string *gapstring_to_string(const gapstring *g)
+{
+	gapstring_view view = gapstring_strands(g);
+	string *s = string_reserve(NULL, gapstring_length(g) + 1);
+	s = string_append_strand(s, view.before);
+	s = string_append_strand(s, view.after);
+	return s;
+}
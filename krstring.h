@@ -2,14 +2,32 @@
 #define KRSTRING_H_INCLUDED
 
 #include <stdlib.h>
+#include <stddef.h>
 #include <stdbool.h>
 #include <stdio.h>
 
+#include "krclib.h"
+
 typedef struct string string;
 
+// How much string_reserve() and the bulk functions grow a full string.
+// The setting is process-wide and unsynchronised.
+enum string_growth {
+	STRING_GROW_EXACT,      // just what's needed
+	STRING_GROW_HALF,       // 1.5x
+	STRING_GROW_DOUBLE,     // 2x (default)
+};
+
+void        string_set_growth(enum string_growth growth);
+
 string     *string_create(const char *str);
 string     *string_reserve(string *s, size_t bigger);
 string     *string_pushc(string *s, int c);
+string     *string_append(string *s, const char *data, size_t n);
+string     *string_append_strand(string *s, struct strand str);
+string     *string_append_String(string *s, String str);
+string     *string_insert(string *s, size_t at, const char *data, size_t n);
+string     *string_replace(string *s, size_t at, size_t len, const char *data, size_t n);
 void        string_dispose(string *s);
 
 size_t      string_length(const string *s);
@@ -20,11 +38,79 @@ const char *string_cstr(const string *s);
 bool        string_equals(const string *s, const char *cstr);
 
 string     *string_clear(string *s);
-string     *string_copy(const char *from);
+string     *string_copy(const string *from);
+string     *string_share(string *s);
+bool        string_is_shared(const string *s);
 string     *string_format(const char *format, ...);
 string     *string_fgetline(FILE *in, string *s);
 void        string_swap(string **a, string **b);
 
 void        string_puts(const string *s);
 
+
+// Small string: a value handle that keeps strings of up to
+// SSTRING_LOCAL_CAP chars inline and only moves to a heap string when it
+// grows past that. A zeroed sstring is a valid empty string.
+
+enum {
+	SSTRING_LOCAL_SIZE = 24,
+	SSTRING_LOCAL_CAP  = SSTRING_LOCAL_SIZE - 2,   // less NUL and tag bytes
+	SSTRING_ON_HEAP    = 0xFF
+};
+
+// The last byte of local is a tag holding the local length, or
+// SSTRING_ON_HEAP once the chars have moved to a heap string.
+typedef union sstring {
+	string *heap;
+	char    local[SSTRING_LOCAL_SIZE];
+} sstring;
+
+sstring     sstring_create(const char *str);
+void        sstring_reserve(sstring *s, size_t bigger);
+void        sstring_pushc(sstring *s, int c);
+void        sstring_dispose(sstring *s);
+
+size_t      sstring_length(const sstring *s);
+size_t      sstring_size(const sstring *s);
+bool        sstring_is_local(const sstring *s);
+bool        sstring_is_full(const sstring *s);
+bool        sstring_is_empty(const sstring *s);
+const char *sstring_cstr(const sstring *s);
+bool        sstring_equals(const sstring *s, const char *cstr);
+
+void        sstring_clear(sstring *s);
+
+
+// Gap string: text with a movable cursor for editing. The chars before
+// and after the cursor sit at the two ends of one allocation with the
+// unused space (the gap) between them, so inserting or deleting at the
+// cursor is O(1) amortized and moving the cursor only shifts the chars
+// it passes over. Like string, a NULL gapstring is empty and functions
+// that may grow it return the new pointer.
+
+typedef struct gapstring gapstring;
+
+// The contents, in order, as the text before and after the cursor.
+typedef struct gapstring_view {
+	struct strand before;
+	struct strand after;
+} gapstring_view;
+
+gapstring  *gapstring_create(const char *str);
+gapstring  *gapstring_reserve(gapstring *g, size_t bigger);
+gapstring  *gapstring_insert(gapstring *g, const char *data, size_t n);
+gapstring  *gapstring_pushc(gapstring *g, int c);
+void        gapstring_dispose(gapstring *g);
+
+void        gapstring_delete_before(gapstring *g, size_t n);
+void        gapstring_delete_after(gapstring *g, size_t n);
+void        gapstring_move_to(gapstring *g, size_t at);
+void        gapstring_move_by(gapstring *g, ptrdiff_t delta);
+
+size_t      gapstring_cursor(const gapstring *g);
+size_t      gapstring_length(const gapstring *g);
+size_t      gapstring_size(const gapstring *g);
+gapstring_view gapstring_strands(const gapstring *g);
+string     *gapstring_to_string(const gapstring *g);
+
 #endif
@@ -3,6 +3,7 @@
 #include <string.h>
 #include <errno.h>
 #include <limits.h>
+#include <unistd.h>
 
 #include "krclib.h"
 
@@ -120,7 +121,7 @@ struct maze *maze_create(int height, int width, struct except_frame *xf)
 }
 
 
-void maze_draw_ascii(struct maze *maze)
+void maze_draw_ascii(struct maze *maze, writer *out)
 {
 	struct grid_row row = row_start(&maze->grid, maze->cells);
 
@@ -130,38 +131,38 @@ void maze_draw_ascii(struct maze *maze)
 		     cell != row.back; ++cell)
 		{
 			if (cell->north)
-				printf(" | ");
+				writer_puts(out, STR(" | "));
 			else
-				printf("   ");
+				writer_puts(out, STR("   "));
 		}
-		putchar('\n');
+		writer_putc(out, '\n');
 
 		for (struct maze_cell *cell = row.front;
 		     cell != row.back; ++cell)
 		{
 			if (cell->west)
-				putchar('-');
+				writer_putc(out, '-');
 			else
-				putchar(' ');
+				writer_putc(out, ' ');
 
-			putchar('+');
+			writer_putc(out, '+');
 
 			if (cell->east)
-				putchar('-');
+				writer_putc(out, '-');
 			else
-				putchar(' ');
+				writer_putc(out, ' ');
 		}
-		putchar('\n');
+		writer_putc(out, '\n');
 
 		for (struct maze_cell *cell = row.front;
 		     cell != row.back; ++cell)
 		{
 			if (cell->south)
-				printf(" | ");
+				writer_puts(out, STR(" | "));
 			else
-				printf("   ");
+				writer_puts(out, STR("   "));
 		}
-		putchar('\n');
+		writer_putc(out, '\n');
 	}
 }
 
@@ -181,23 +182,21 @@ unsigned parse_uint_option(int argi, int argc, char *argv[], const char *name)
 		exit(0);
 	}
 
-	unsigned long n = strtoul(argv[argi], NULL, 0);
+	// Base 0, so options may be given in hex (0x...) or octal (0...).
+	char *end = NULL;
+	errno = 0;
+	unsigned long n = strtoul(argv[argi], &end, 0);
 
-	if (errno) {
-		fprintf(stderr, "ERROR: argument %s: %s\n", name, strerror(errno));
+	if (argv[argi][0] != '-' && (errno == ERANGE || n > UINT32_MAX)) {
+		fprintf(stderr, "ERROR: %s must be less than or equal to %u.\n", name, UINT32_MAX);
 		exit(0);
 	}
 
-	if (n == 0) {
+	if (n == 0 || end == argv[argi] || *end != '\0' || n > UINT32_MAX) {
 		fprintf(stderr, "ERROR: %s must be a number greater than zero.\n", name);
 		exit(0);
 	} 
 
-	if (n > (unsigned long)UINT_MAX) {
-		fprintf(stderr, "ERROR: %s must be less than or equal to %u.\n", name, UINT_MAX);
-		exit(0);
-	}
-
 	return n; 
 }
 
@@ -257,7 +256,10 @@ int main(int argc, char *argv[])
 		maze_cell_link(cell, neighbors[rand()%n]);
 	}
 
-	maze_draw_ascii(maze);
+	static char out_buf[1<<16];
+	writer out = WRITER_INIT(STDOUT_FILENO, out_buf);
+	maze_draw_ascii(maze, &out);
+	writer_flush(&out);
 
 	free(maze);
 	except_dispose(&xf);
@@ -5,6 +5,9 @@
 #include <setjmp.h>
 #include <limits.h>
 #include <ctype.h>
+#include <math.h>
+#include <float.h>
+#include <unistd.h>
 
 #define USING_KR_NAMESPACE
 #include "krclib.h"
@@ -537,6 +540,126 @@ TEST_CASE(return_trimmed_span)
 	TEST( strand_equals(strand_trim(spaces, isspace), STR("")) );
 }
 
+// Collect up to 8 fields from a splitter, return the number found.
+static int split_all(strand_splitter it, struct strand fields[8])
+{
+	int n = 0;
+	while (n < 8 && strand_split_next(&it, &fields[n]))
+		++n;
+	return n;
+}
+
+TEST_CASE(split_strand_by_char)
+{
+	struct strand f[8];
+
+	TEST(split_all(strand_split_char(STR("a,bc,,d"), ','), f) == 4);
+	TEST(strand_equals(f[0], STR("a")));
+	TEST(strand_equals(f[1], STR("bc")));
+	TEST(strand_equals(f[2], STR("")));
+	TEST(strand_equals(f[3], STR("d")));
+
+	TEST(split_all(strand_split_char(STR("abc"), ','), f) == 1);
+	TEST(strand_equals(f[0], STR("abc")));
+
+	TEST(split_all(strand_split_char(STR("x,"), ','), f) == 2);
+	TEST(strand_is_empty(f[1]));
+
+	TEST(split_all(strand_split_char((struct strand){0}, ','), f) == 0);
+}
+
+TEST_CASE(split_strand_by_char_set)
+{
+	struct strand f[8];
+
+	TEST(split_all(strand_split_any(STR("key = value;x"), STR(" =;")), f) == 5);
+	TEST(strand_equals(f[0], STR("key")));
+	TEST(strand_equals(f[1], STR("")));
+	TEST(strand_equals(f[2], STR("")));
+	TEST(strand_equals(f[3], STR("value")));
+	TEST(strand_equals(f[4], STR("x")));
+}
+
+TEST_CASE(split_String_by_substring)
+{
+	struct strand f[8];
+	String text = Str("one::two:three::");
+
+	TEST(split_all(strand_split_str(String_strand(text), STR("::")), f) == 3);
+	TEST(strand_equals(f[0], STR("one")));
+	TEST(strand_equals(f[1], STR("two:three")));
+	TEST(strand_equals(f[2], STR("")));
+
+	TEST(split_all(strand_split_str(STR("a"), STR("::")), f) == 1);
+	TEST(strand_equals(f[0], STR("a")));
+}
+
+TEST_CASE(join_strands)
+{
+	struct strand parts[] = { STR("a"), STR("bc"), STR(""), STR("d") };
+
+	struct strbuf buf = STRBUF_INIT((char[16]){});
+	TEST(strbuf_join(&buf, parts, ARRAY_SIZE(parts), STR(", ")) == STATUS_OK);
+	TEST(strand_equals(strbuf_strand(buf), STR("a, bc, , d")));
+
+	struct strbuf small = STRBUF_INIT((char[4]){});
+	TEST(strbuf_join(&small, parts, ARRAY_SIZE(parts), STR(", ")) == STATUS_OUT_OF_SPACE);
+	TEST(strbuf_length(&small) == 0);
+
+	Byte storage[64];
+	Arena arena = { storage, storage + sizeof(storage) };
+	struct strand joined = strand_join(&arena, parts, ARRAY_SIZE(parts), STR("/"));
+	TEST(strand_equals(joined, STR("a/bc//d")));
+	TEST(*joined.back == '\0');
+
+	TEST(strand_is_empty(strand_join(&arena, parts, 0, STR("/"))));
+}
+
+TEST_CASE(compare_strands_ignoring_case)
+{
+	TEST( strand_equals_nocase(STR("Content-Type"), STR("content-type")));
+	TEST( strand_equals_nocase(STR("ACCEPT-ENCODING: GZIP"), STR("accept-encoding: gzip")));
+	TEST( strand_equals_nocase(STR(""), (struct strand){0}));
+	TEST(!strand_equals_nocase(STR("Content-Type"), STR("content-typo")));
+	TEST(!strand_equals_nocase(STR("abc"), STR("abcd")));
+
+	// Only ASCII letters fold; '@' and '`' sit next to 'A' and 'a'.
+	TEST(!strand_equals_nocase(STR("@"), STR("`")));
+	TEST(!strand_equals_nocase(STR("[\\]^_@@@@"), STR("{|}~\x7F````")));
+	TEST(!strand_equals_nocase(STR("caf\xC3\x89"), STR("caf\xC3\xA9")));
+	TEST( strand_equals_nocase(STR("CAF\xC3\xA9"), STR("caf\xC3\xA9")));
+
+	TEST(strand_compare_nocase(STR("apple"), STR("BANANA")) < 0);
+	TEST(strand_compare_nocase(STR("Banana"), STR("apple")) > 0);
+	TEST(strand_compare_nocase(STR("HEADER-NAME"), STR("header-name")) == 0);
+	TEST(strand_compare_nocase(STR("head"), STR("HEADER")) < 0);
+	TEST(strand_compare_nocase(STR("headers"), STR("HEADER")) > 0);
+}
+
+TEST_CASE(fold_ascii_case)
+{
+	char text[] = "Hello, WORLD! Caf\xC3\x89 [@`{]";
+	ascii_to_lower(text, strlen(text));
+	TEST(!strcmp(text, "hello, world! caf\xC3\x89 [@`{]"));
+
+	ascii_to_upper(text, strlen(text));
+	TEST(!strcmp(text, "HELLO, WORLD! CAF\xC3\x89 [@`{]"));
+
+	struct strbuf buf = STRBUF_INIT((char[32]){});
+	TEST(strbuf_cat_lower(&buf, STR("X-Forwarded-For")) == STATUS_OK);
+	TEST(strand_equals(strbuf_strand(buf), STR("x-forwarded-for")));
+}
+
+TEST_CASE(hash_ignoring_case)
+{
+	char lower[] = "accept-encoding: gzip, deflate";
+	struct strand mixed = STR("Accept-Encoding: GZIP, Deflate");
+
+	TEST(hash_nocase(mixed) == hash(byte_span_init_n((Byte*)lower, strlen(lower))));
+	TEST(hash_nocase(mixed) == hash_nocase(STR("ACCEPT-ENCODING: gzip, DEFLATE")));
+	TEST(hash_nocase(mixed) != hash_nocase(STR("Accept-Encoding: br")));
+}
+
 TEST_CASE(null_strbuf_properties)
 {
 	struct strbuf *buf = NULL;
@@ -554,23 +677,6 @@ TEST_CASE(empty_strbuf_properties)
 	TEST(strbuf_cap(&buf) == 32);
 }
 
-enum status strbuf_cat(struct strbuf *buf, struct strand str)
-{
-	int len = strand_length(str);
-	if (len > strbuf_cap(buf))
-		return STATUS_OUT_OF_SPACE;
-
-	memcpy(buf->back, str.front, len);
-	buf->back += len;
-
-	return STATUS_OK;
-}
-
-struct strand strbuf_strand(struct strbuf buf)
-{
-	return (struct strand){ .front = buf.front, .back = buf.back };
-
-}
 TEST_CASE(concat_strand_to_strbuf)
 {
 	struct strbuf buf = STRBUF_INIT((char[100]){});
@@ -598,6 +704,942 @@ TEST_CASE(concat_strand_to_strbuf)
 
 }
 
+TEST_CASE(format_into_strbuf)
+{
+	struct strbuf buf = STRBUF_INIT((char[32]){});
+
+	TEST(strbuf_printf(&buf, "%d-%s", 42, "abc") == STATUS_OK);
+	TEST(strbuf_length(&buf) == 6);
+	TEST(!strcmp(buf.front, "42-abc"));
+
+	TEST(strbuf_printf(&buf, " %.2f", 0.5) == STATUS_OK);
+	TEST(!strcmp(buf.front, "42-abc 0.50"));
+	TEST(strbuf_length(&buf) == 11);
+}
+
+TEST_CASE(format_into_strbuf_truncates)
+{
+	struct strbuf buf = STRBUF_INIT((char[8]){});
+
+	TEST(strbuf_printf(&buf, "%s", "Hello, world.") == STATUS_OUT_OF_SPACE);
+	TEST(strbuf_length(&buf) == 7);
+	TEST(!strcmp(buf.front, "Hello, "));
+
+	TEST(strbuf_printf(&buf, "x") == STATUS_OUT_OF_SPACE);
+	TEST(strbuf_length(&buf) == 7);
+}
+
+//-----------------------------------------------------------------------------
+// Number formatting
+//
+
+TEST_CASE(format_integers)
+{
+	char out[INT_STR_SIZE], expect[INT_STR_SIZE];
+
+	int64_t samples[] = { 0, 1, -1, 9, 10, 99, 100, -12345, 1000000007,
+	                      INT32_MAX, INT32_MIN, INT64_MAX, INT64_MIN };
+
+	for (int i = 0; i < ARRAY_SIZE(samples); ++i) {
+		int len = int64_to_str(out, samples[i]);
+		snprintf(expect, sizeof(expect), "%lld", (long long)samples[i]);
+		TEST(!strcmp(out, expect));
+		TEST(len == (int)strlen(expect));
+	}
+
+	TEST(uint64_to_str(out, UINT64_MAX) == 20);
+	TEST(!strcmp(out, "18446744073709551615"));
+
+	TEST(uint32_to_str(out, UINT32_MAX) == 10);
+	TEST(!strcmp(out, "4294967295"));
+	TEST(int32_to_str(out, INT32_MIN) == 11);
+	TEST(!strcmp(out, "-2147483648"));
+	TEST(int32_to_str(out, 7) == 1);
+	TEST(!strcmp(out, "7"));
+}
+
+TEST_CASE(format_doubles_shortest)
+{
+	char out[DOUBLE_STR_SIZE];
+
+	struct { double d; const char *s; } cases[] = {
+		{ 0.0, "0" },       { -0.0, "-0" },     { 1.0, "1" },
+		{ 0.1, "0.1" },     { -2.5, "-2.5" },   { 1.0/3, "0.3333333333333333" },
+		{ 100.0, "100" },   { 1e21, "1e21" },   { 1e-7, "1e-7" },
+		{ 123e-9, "1.23e-7" }, { 0.000001, "0.000001" },
+		{ 5e-324, "5e-324" }, { 1.7976931348623157e308, "1.7976931348623157e308" },
+		{ INFINITY, "inf" }, { -INFINITY, "-inf" }, { NAN, "nan" },
+	};
+
+	for (int i = 0; i < ARRAY_SIZE(cases); ++i) {
+		int len = double_to_str(out, cases[i].d);
+		TEST(!strcmp(out, cases[i].s));
+		TEST(len == (int)strlen(cases[i].s));
+	}
+}
+
+TEST_CASE(format_doubles_round_trip)
+{
+	char out[DOUBLE_STR_SIZE];
+	Xorshifter rng = { .x = 0x12345678, .a = 13, .b = 17, .c = 5 };
+
+	int failures = 0;
+	for (int i = 0; i < 100000; ++i) {
+		uint64_t bits = (uint64_t)Xorshift_rand(&rng) << 32 | Xorshift_rand(&rng);
+		double d;
+		memcpy(&d, &bits, sizeof(d));
+		if (!isfinite(d))
+			continue;
+
+		double_to_str(out, d);
+		failures += (strtod(out, NULL) != d);
+	}
+	TEST(failures == 0);
+}
+
+TEST_CASE(format_numbers_into_strbuf)
+{
+	struct strbuf buf = STRBUF_INIT((char[32]){});
+
+	TEST(strbuf_put_int(&buf, -42) == STATUS_OK);
+	TEST(strbuf_cat(&buf, STR(" ")) == STATUS_OK);
+	TEST(strbuf_put_uint(&buf, 42) == STATUS_OK);
+	TEST(strbuf_cat(&buf, STR(" ")) == STATUS_OK);
+	TEST(strbuf_put_double(&buf, 0.25) == STATUS_OK);
+	TEST(strand_equals(strbuf_strand(buf), STR("-42 42 0.25")));
+
+	struct strbuf small = STRBUF_INIT((char[4]){});
+	TEST(strbuf_put_int(&small, 123456) == STATUS_OUT_OF_SPACE);
+	TEST(strbuf_length(&small) == 0);
+}
+
+//-----------------------------------------------------------------------------
+// Number parsing
+//
+
+TEST_CASE(parse_unsigned_integers)
+{
+	uint64_t u64 = 0;
+	int used = 0;
+
+	TEST(parse_uint64(STR("12345xyz"), &u64, &used) == STATUS_OK);
+	TEST(u64 == 12345);
+	TEST(used == 5);
+
+	TEST(parse_uint64(STR("18446744073709551615"), &u64, &used) == STATUS_OK);
+	TEST(u64 == UINT64_MAX);
+	TEST(used == 20);
+
+	u64 = 7;
+	TEST(parse_uint64(STR("18446744073709551616"), &u64, &used) == STATUS_MATH_OVERFLOW);
+	TEST(u64 == 7);
+	TEST(used == 20);
+
+	TEST(parse_uint64(STR("x1"), &u64, &used) == STATUS_ERROR);
+	TEST(used == 0);
+	TEST(parse_uint64(STR("-1"), &u64, NULL) == STATUS_ERROR);
+	TEST(parse_uint64((struct strand){0}, &u64, NULL) == STATUS_ERROR);
+
+	uint8_t u8 = 0;
+	TEST(parse_uint8(STR("255"), &u8, NULL) == STATUS_OK);
+	TEST(u8 == 255);
+	TEST(parse_uint8(STR("256"), &u8, NULL) == STATUS_MATH_OVERFLOW);
+
+	uint32_t u32 = 0;
+	TEST(parse_uint32(STR("4294967295"), &u32, NULL) == STATUS_OK);
+	TEST(u32 == UINT32_MAX);
+	TEST(parse_uint32(STR("4294967296"), &u32, NULL) == STATUS_MATH_OVERFLOW);
+}
+
+TEST_CASE(parse_signed_integers)
+{
+	int64_t i64 = 0;
+	int used = 0;
+
+	TEST(parse_int64(STR("-9223372036854775808"), &i64, &used) == STATUS_OK);
+	TEST(i64 == INT64_MIN);
+	TEST(used == 20);
+
+	TEST(parse_int64(STR("+42,"), &i64, &used) == STATUS_OK);
+	TEST(i64 == 42);
+	TEST(used == 3);
+
+	TEST(parse_int64(STR("9223372036854775808"), &i64, NULL) == STATUS_MATH_OVERFLOW);
+	TEST(parse_int64(STR("-"), &i64, &used) == STATUS_ERROR);
+	TEST(used == 0);
+
+	int32_t i32 = 0;
+	TEST(parse_int32(STR("-2147483648"), &i32, NULL) == STATUS_OK);
+	TEST(i32 == INT32_MIN);
+	TEST(parse_int32(STR("2147483648"), &i32, NULL) == STATUS_MATH_OVERFLOW);
+
+	int16_t i16 = 0;
+	TEST(parse_int16(STR("-32769"), &i16, NULL) == STATUS_MATH_OVERFLOW);
+
+	int8_t i8 = 0;
+	TEST(parse_int8(STR("-128"), &i8, NULL) == STATUS_OK);
+	TEST(i8 == -128);
+}
+
+TEST_CASE(parse_doubles)
+{
+	double d = 0;
+	int used = 0;
+
+	TEST(parse_double(STR("3.25;"), &d, &used) == STATUS_OK);
+	TEST(d == 3.25);
+	TEST(used == 4);
+
+	TEST(parse_double(STR("-0.1e-2"), &d, NULL) == STATUS_OK);
+	TEST(d == -0.001);
+
+	TEST(parse_double(STR(".5"), &d, NULL) == STATUS_OK);
+	TEST(d == 0.5);
+
+	TEST(parse_double(STR("12e"), &d, &used) == STATUS_OK);
+	TEST(d == 12.0);
+	TEST(used == 2);
+
+	TEST(parse_double(STR("1.7976931348623157e308"), &d, NULL) == STATUS_OK);
+	TEST(d == DBL_MAX);
+	TEST(parse_double(STR("4.9406564584124654e-324"), &d, NULL) == STATUS_OK);
+	TEST(d == 5e-324);
+	TEST(parse_double(STR("0.000000000000000000000000000000000001"), &d, NULL) == STATUS_OK);
+	TEST(d == 1e-36);
+	TEST(parse_double(STR("3.14159265358979323846264338327950288"), &d, NULL) == STATUS_OK);
+	TEST(d == 3.14159265358979323846264338327950288);
+
+	TEST(parse_double(STR("1e400"), &d, NULL) == STATUS_MATH_OVERFLOW);
+	TEST(isinf(d));
+	TEST(parse_double(STR("-Infinity"), &d, &used) == STATUS_OK);
+	TEST(isinf(d) && d < 0);
+	TEST(used == 9);
+	TEST(parse_double(STR("nan"), &d, NULL) == STATUS_OK);
+	TEST(isnan(d));
+
+	TEST(parse_double(STR("-.e5"), &d, &used) == STATUS_ERROR);
+	TEST(used == 0);
+}
+
+TEST_CASE(parse_doubles_round_trip)
+{
+	char text[DOUBLE_STR_SIZE];
+	Xorshifter rng = { .x = 0x9E3779B9, .a = 13, .b = 17, .c = 5 };
+
+	int failures = 0;
+	for (int i = 0; i < 100000; ++i) {
+		uint64_t bits = (uint64_t)Xorshift_rand(&rng) << 32 | Xorshift_rand(&rng);
+		double d, parsed = 0;
+		memcpy(&d, &bits, sizeof(d));
+		if (!isfinite(d))
+			continue;
+
+		// Shortest form, and 17 significant digits.
+		int len = double_to_str(text, d);
+		parse_double(strand_init_n(text, len), &parsed, NULL);
+		failures += (parsed != d);
+
+		len = snprintf(text, sizeof(text), "%.16e", d);
+		parse_double(strand_init_n(text, len), &parsed, NULL);
+		failures += (parsed != d);
+	}
+	TEST(failures == 0);
+}
+
+// Inputs that skip Eisel-Lemire: long mantissas, subnormals and exact
+// halfway cases. The test runs in the C locale, where strtod is correct.
+TEST_CASE(parse_doubles_exact_slow_path)
+{
+	static const char *const cases[] = {
+		"2.4703282292062327e-324",      // just under half the least subnormal
+		"2.4703282292062328e-324",      // just over it
+		"2.2250738585072011e-308",
+		"2.2250738585072012e-308",
+		"9007199254740993",             // 2^53 + 1, a tie rounding to even
+		"9007199254740993.0000000000000000000000000000001",
+		"1.00000000000000011102230246251565404236316680908203125",
+		"1.00000000000000011102230246251565404236316680908203124",
+		"179769313486231580793728971405303415079934132710037826936173778980444968292764750946649017977587207096330286416692887910946555547851940402630657488671505820681908902000708383676273854845817711531764475730270069855571366959622842914819860834936475292719074168444365510704342711559699508093042880177904174497791.9",
+		"0.000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000494065645841246544",
+		"123456789012345678901234567890e-320",
+		"1e-400",
+	};
+
+	int failures = 0;
+	for (int i = 0; i < ARRAY_SIZE(cases); ++i) {
+		double d = 0;
+		parse_double(strand_init_n(cases[i], strlen(cases[i])), &d, NULL);
+		failures += (d != strtod(cases[i], NULL));
+	}
+	TEST(failures == 0);
+
+	// Random 20 to 40 digit mantissas across the whole exponent range.
+	char text[64];
+	uint32_t x = 0x5EED1234;
+	failures = 0;
+	for (int i = 0; i < 20000; ++i) {
+		int len = 0;
+		XORSHIFT_TEMPLATE(x, 13, 17, 5);
+		int digits = 20 + x % 21;
+		for (int k = 0; k < digits; ++k) {
+			XORSHIFT_TEMPLATE(x, 13, 17, 5);
+			text[len++] = '0' + x % 10;
+			if (k == 0)  text[len++] = '.';
+		}
+		XORSHIFT_TEMPLATE(x, 13, 17, 5);
+		len += snprintf(text + len, sizeof(text) - len, "e%d", (int)(x % 660) - 330);
+
+		double d = 0;
+		parse_double(strand_init_n(text, len), &d, NULL);
+		failures += (d != strtod(text, NULL));
+	}
+	TEST(failures == 0);
+}
+
+//-----------------------------------------------------------------------------
+// writer
+//
+
+// Drain everything written to a pipe into buf, return number of bytes.
+static int read_pipe(int fd, char *buf, int size)
+{
+	int total = 0, n = 0;
+	while ((n = read(fd, buf + total, size - total)) > 0)
+		total += n;
+	return total;
+}
+
+TEST_CASE(writer_buffers_until_flush)
+{
+	int fds[2];
+	TEST(pipe(fds) == 0);
+
+	writer w = WRITER_INIT(fds[1], (char[16]){});
+	writer_puts(&w, STR("abc"));
+	writer_putc(&w, '-');
+	writer_put_String(&w, Str("xyz"));
+
+	TEST(strbuf_length(&w.buf) == 7);
+	TEST(strand_equals(strbuf_strand(w.buf), STR("abc-xyz")));
+
+	TEST(writer_flush(&w) == STATUS_OK);
+	TEST(strbuf_length(&w.buf) == 0);
+	close(fds[1]);
+
+	char out[64] = "";
+	TEST(read_pipe(fds[0], out, sizeof(out)) == 7);
+	TEST(!strcmp(out, "abc-xyz"));
+	close(fds[0]);
+}
+
+TEST_CASE(writer_formats_numbers)
+{
+	int fds[2];
+	TEST(pipe(fds) == 0);
+
+	writer w = WRITER_INIT(fds[1], (char[8]){});
+	writer_put_int(&w, 0);
+	writer_putc(&w, ' ');
+	writer_put_int(&w, -42);
+	writer_putc(&w, ' ');
+	writer_put_int(&w, LLONG_MIN);
+	writer_putc(&w, ' ');
+	writer_put_uint(&w, ULLONG_MAX);
+	writer_putc(&w, ' ');
+	writer_put_double(&w, 2.5);
+	TEST(writer_flush(&w) == STATUS_OK);
+	close(fds[1]);
+
+	char out[128] = "";
+	read_pipe(fds[0], out, sizeof(out));
+	TEST(!strcmp(out, "0 -42 -9223372036854775808 18446744073709551615 2.5"));
+	close(fds[0]);
+}
+
+TEST_CASE(writer_sends_large_writes_directly)
+{
+	int fds[2];
+	TEST(pipe(fds) == 0);
+
+	char big[100];
+	memset(big, 'x', sizeof(big));
+
+	writer w = WRITER_INIT(fds[1], (char[16]){});
+	writer_puts(&w, STR("head:"));
+	TEST(writer_write(&w, big, sizeof(big)) == STATUS_OK);
+	TEST(strbuf_length(&w.buf) == 0);
+	close(fds[1]);
+
+	char out[256] = "";
+	TEST(read_pipe(fds[0], out, sizeof(out)) == 105);
+	TEST(!strncmp(out, "head:xxxx", 9));
+	close(fds[0]);
+}
+
+TEST_CASE(writer_errors_are_sticky)
+{
+	writer w = WRITER_INIT(-1, (char[4]){});
+	writer_puts(&w, STR("abcdef"));
+	TEST(w.status == STATUS_IO_FAILURE);
+
+	writer_putc(&w, 'x');
+	TEST(writer_flush(&w) == STATUS_IO_FAILURE);
+}
+
+//-----------------------------------------------------------------------------
+// rope
+//
+
+TEST_CASE(concat_ropes)
+{
+	static Byte storage[1<<14];
+	Arena arena = { storage, storage + sizeof(storage) };
+
+	const rope *r = NULL;
+	TEST(rope_length(r) == 0);
+
+	r = rope_concat(&arena, r, rope_strand(&arena, STR("Hello, ")));
+	r = rope_concat(&arena, r, rope_String(&arena, Str("world.")));
+	TEST(rope_length(r) == 13);
+	TEST(rope_depth(r) == 0);   // short pieces merge into one leaf
+	TEST(rope_at(r, 0) == 'H');
+	TEST(rope_at(r, -1) == '.');
+
+	String flat = rope_flatten(&arena, r);
+	TEST(String_equals(flat, Str("Hello, world.")));
+}
+
+TEST_CASE(long_ropes_stay_balanced)
+{
+	static Byte storage[1<<20];
+	Arena arena = { storage, storage + sizeof(storage) };
+
+	const rope *r = NULL;
+	int n = 1000;
+
+	// Pieces just too long to be merged, so each one is a leaf.
+	for (int i = 0; i < n; ++i) {
+		Utf8 *piece = alloc(&arena, 1, 1, ROPE_SHORT_LEAF + 1, 'a' + i % 26, SRC_HERE).data;
+		String s = { .data = piece, .length = ROPE_SHORT_LEAF + 1 };
+		r = rope_concat(&arena, r, rope_String(&arena, s));
+	}
+
+	TEST(rope_length(r) == n * (ROPE_SHORT_LEAF + 1));
+	TEST(rope_depth(r) <= 15);   // AVL: depth < 1.44 log2(n)
+
+	for (int i = 0; i < n; ++i)
+		TEST(rope_at(r, i * (ROPE_SHORT_LEAF+1) + 7) == 'a' + i % 26);
+
+	const rope *mid = rope_slice(&arena, r, ROPE_SHORT_LEAF, 3*(ROPE_SHORT_LEAF+1) + 1);
+	String flat = rope_flatten(&arena, mid);
+	TEST(flat.length == 2*(ROPE_SHORT_LEAF+1) + 2);
+	TEST(flat.data[0] == 'a');
+	TEST(flat.data[1] == 'b');
+	TEST(flat.data[flat.length-1] == 'd');
+}
+
+TEST_CASE(write_rope_to_file)
+{
+	static Byte storage[1<<12];
+	Arena arena = { storage, storage + sizeof(storage) };
+
+	char big[100];
+	memset(big, 'x', sizeof(big));
+
+	const rope *r = rope_strand(&arena, STR("head:"));
+	r = rope_concat(&arena, r, rope_strand(&arena, strand_init_n(big, sizeof(big))));
+	r = rope_concat(&arena, r, rope_strand(&arena, STR(":tail")));
+
+	int fds[2];
+	TEST(pipe(fds) == 0);
+	TEST(rope_write(r, fds[1]) == STATUS_OK);
+	close(fds[1]);
+
+	char out[256] = "";
+	TEST(read_pipe(fds[0], out, sizeof(out)) == 110);
+	TEST(!strncmp(out, "head:xx", 7));
+	TEST(!strcmp(out + 105, ":tail"));
+	close(fds[0]);
+}
+
+//-----------------------------------------------------------------------------
+// utf8
+//
+
+TEST_CASE(validate_utf8)
+{
+	TEST(utf8_is_valid(Str("")));
+	TEST(utf8_is_valid(Str("plain ASCII text, longer than a word")));
+	TEST(utf8_is_valid(Str("na\xC3\xAFve caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80")));
+
+	TEST(utf8_invalid_at(Str("abcdefghij\x80")) == 10);          // stray continuation
+	TEST(utf8_invalid_at(Str("ab\xC0\xAF")) == 2);               // overlong '/'
+	TEST(utf8_invalid_at(Str("ab\xE0\x80\xAF")) == 2);          // overlong 3 byte
+	TEST(utf8_invalid_at(Str("\xED\xA0\x80")) == 0);             // surrogate
+	TEST(utf8_invalid_at(Str("\xF4\x90\x80\x80")) == 0);        // > U+10FFFF
+	TEST(utf8_invalid_at(Str("abc\xE2\x82")) == 3);              // truncated
+}
+
+TEST_CASE(count_utf8_code_points)
+{
+	String s = Str("na\xC3\xAFve caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80!");
+	TEST(utf8_count(s) == 15);
+	TEST(utf8_count(Str("")) == 0);
+
+	TEST(utf8_offset(s, 0) == 0);
+	TEST(utf8_offset(s, 3) == 4);
+	TEST(utf8_offset(s, 14) == s.length - 1);
+	TEST(utf8_offset(s, 15) == s.length);
+}
+
+TEST_CASE(decode_utf8)
+{
+	String s = Str("a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80\xFFz");
+
+	TEST(utf8_next(&s) == 'a');
+	TEST(utf8_next(&s) == 0xE9);
+	TEST(utf8_next(&s) == 0x20AC);
+	TEST(utf8_next(&s) == 0x1F600);
+	TEST(utf8_next(&s) == UTF8_INVALID);
+	TEST(utf8_next(&s) == 'z');
+	TEST(s.length == 0);
+	TEST(utf8_next(&s) == UTF8_INVALID);
+}
+
+TEST_CASE(encode_utf8_into_strbuf)
+{
+	struct strbuf buf = STRBUF_INIT((char[16]){});
+
+	TEST(strbuf_put_utf8(&buf, 'a') == STATUS_OK);
+	TEST(strbuf_put_utf8(&buf, 0xE9) == STATUS_OK);
+	TEST(strbuf_put_utf8(&buf, 0x20AC) == STATUS_OK);
+	TEST(strbuf_put_utf8(&buf, 0x1F600) == STATUS_OK);
+	TEST(strand_equals(strbuf_strand(buf), STR("a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80")));
+
+	TEST(strbuf_put_utf8(&buf, 0xD800) == STATUS_ERROR);
+	TEST(strbuf_put_utf8(&buf, 0x110000) == STATUS_ERROR);
+}
+
+//-----------------------------------------------------------------------------
+// Aho-Corasick
+//
+
+static bool ac_expect(ac_scanner *scan, int pattern, Size start, Size end)
+{
+	ac_match m;
+	return ac_next(scan, &m) && m.pattern == pattern && m.start == start && m.end == end;
+}
+
+TEST_CASE(find_overlapping_patterns)
+{
+	static Byte storage[1 << 14];
+	Arena arena = { storage, storage + sizeof(storage) };
+	struct strand words[] = { STR("he"), STR("she"), STR("his"), STR("hers") };
+	const ac_matcher *ac = ac_compile(&arena, words, ARRAY_SIZE(words));
+
+	ac_scanner scan = ac_scan(ac, STR("ushers"));
+	TEST(ac_expect(&scan, 1, 1, 4));
+	TEST(ac_expect(&scan, 0, 2, 4));
+	TEST(ac_expect(&scan, 3, 2, 6));
+	TEST(!ac_next(&scan, &(ac_match){0}));
+
+	TEST( ac_contains(ac, STR("this")));
+	TEST(!ac_contains(ac, STR("HERS, not hi")));
+	TEST(!ac_contains(ac, STR("")));
+}
+
+TEST_CASE(report_duplicate_patterns_in_order)
+{
+	static Byte storage[1 << 14];
+	Arena arena = { storage, storage + sizeof(storage) };
+	struct strand words[] = { STR("error"), STR("err"), STR("error") };
+	const ac_matcher *ac = ac_compile(&arena, words, ARRAY_SIZE(words));
+
+	ac_scanner scan = ac_scan(ac, STR("[error]"));
+	TEST(ac_expect(&scan, 1, 1, 4));
+	TEST(ac_expect(&scan, 0, 1, 6));
+	TEST(ac_expect(&scan, 2, 1, 6));
+	TEST(!ac_next(&scan, &(ac_match){0}));
+}
+
+TEST_CASE(stream_matches_across_chunks)
+{
+	static Byte storage[1 << 14];
+	Arena arena = { storage, storage + sizeof(storage) };
+	struct strand words[] = { STR("timeout"), STR("out of memory") };
+	const ac_matcher *ac = ac_compile(&arena, words, ARRAY_SIZE(words));
+
+	ac_scanner scan = ac_scan(ac, STR("read time"));
+	TEST(!ac_next(&scan, &(ac_match){0}));
+
+	ac_feed(&scan, STR("out; out of mem"));
+	TEST(ac_expect(&scan, 0, 5, 12));
+	TEST(!ac_next(&scan, &(ac_match){0}));
+
+	ac_feed(&scan, STR("ory"));
+	TEST(ac_expect(&scan, 1, 14, 27));
+	TEST(!ac_next(&scan, &(ac_match){0}));
+}
+
+TEST_CASE(ac_agrees_with_naive_search)
+{
+	static Byte storage[1 << 16];
+	Arena arena = { storage, storage + sizeof(storage) };
+	struct strand words[] = { STR("ab"), STR("bab"), STR("aaa"), STR("b"), STR("abba") };
+	const ac_matcher *ac = ac_compile(&arena, words, ARRAY_SIZE(words));
+
+	char text[500];
+	uint64_t seed = 42;
+	for (int i = 0; i < (int)sizeof(text); ++i) {
+		seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+		text[i] = "abc"[(seed >> 33) % 3];
+	}
+
+	int expected = 0, found = 0;
+	for (int end = 1; end <= (int)sizeof(text); ++end)
+		for (int w = 0; w < (int)ARRAY_SIZE(words); ++w) {
+			int n = strand_length(words[w]);
+			expected += (n <= end && !memcmp(text + end - n, words[w].front, n));
+		}
+
+	ac_scanner scan = ac_scan(ac, strand_init_n(text, sizeof(text)));
+	ac_match m;
+	Size last_end = 0;
+	bool all_real = true, ordered = true;
+	while (ac_next(&scan, &m)) {
+		++found;
+		all_real &= !memcmp(text + m.start, words[m.pattern].front, m.end - m.start);
+		ordered &= (m.end >= last_end);
+		last_end = m.end;
+	}
+
+	TEST(found == expected);
+	TEST(all_real);
+	TEST(ordered);
+}
+
+// With every byte value in some pattern there are 257 byte classes,
+// counting the one for bytes in no pattern.
+TEST_CASE(ac_patterns_using_every_byte)
+{
+	static Byte storage[1 << 20];
+	Arena arena = { storage, storage + sizeof(storage) };
+
+	char every[256];
+	for (int b = 0; b < 256; ++b)
+		every[b] = b;
+	struct strand words[] = {
+		strand_init_n(every, 256), STR("\xff\x00"), STR("\x01\xff"), STR("\xff"),
+	};
+	const ac_matcher *ac = ac_compile(&arena, words, ARRAY_SIZE(words));
+	TEST(ac->classes == 257);
+
+	char text[2000];
+	uint64_t seed = 7;
+	for (int i = 0; i < (int)sizeof(text); ++i) {
+		seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+		text[i] = (i >= 1000 && i < 1256) ? every[i - 1000] : (char)((seed >> 33) % 4 ? seed >> 40 : 0xFF);
+	}
+
+	int expected = 0, found = 0;
+	for (int end = 1; end <= (int)sizeof(text); ++end)
+		for (int w = 0; w < (int)ARRAY_SIZE(words); ++w) {
+			int n = strand_length(words[w]);
+			expected += (n <= end && !memcmp(text + end - n, words[w].front, n));
+		}
+
+	ac_scanner scan = ac_scan(ac, strand_init_n(text, sizeof(text)));
+	ac_match m;
+	bool all_real = true;
+	while (ac_next(&scan, &m)) {
+		++found;
+		all_real &= !memcmp(text + m.start, words[m.pattern].front, m.end - m.start);
+	}
+	TEST(found == expected);
+	TEST(all_real);
+	TEST(ac_contains(ac, strand_init_n(every, 256)));
+}
+
+//-----------------------------------------------------------------------------
+// regex
+//
+
+static bool regex_finds(regex *re, struct strand text, const char *expect)
+{
+	struct strand found;
+	if (!regex_find(re, text, &found))
+		return expect == NULL;
+	return expect && strand_equals(found, strand_init_n(expect, strlen(expect)));
+}
+
+TEST_CASE(compile_regex_syntax)
+{
+	static Byte storage[1 << 18];
+	Arena arena = { storage, storage + sizeof(storage) };
+	regex *re;
+
+	TEST(regex_compile(&arena, STR("^(GET|POST) /[a-z0-9_]+\\?id=\\d+$"), &re) == STATUS_OK);
+	TEST(regex_compile(&arena, STR(""), &re) == STATUS_OK);
+	TEST(regex_compile(&arena, STR("a\\$"), &re) == STATUS_OK);
+
+	TEST(regex_compile(&arena, STR("(ab"), &re) == STATUS_ERROR);
+	TEST(regex_compile(&arena, STR("ab)"), &re) == STATUS_ERROR);
+	TEST(regex_compile(&arena, STR("*a"), &re) == STATUS_ERROR);
+	TEST(regex_compile(&arena, STR("[a-"), &re) == STATUS_ERROR);
+	TEST(regex_compile(&arena, STR("[z-a]"), &re) == STATUS_ERROR);
+	TEST(regex_compile(&arena, STR("a^b"), &re) == STATUS_ERROR);
+	TEST(regex_compile(&arena, STR("\\q"), &re) == STATUS_ERROR);
+	TEST(regex_compile(&arena, STR("ab\\"), &re) == STATUS_ERROR);
+}
+
+TEST_CASE(match_whole_strand_with_regex)
+{
+	static Byte storage[1 << 18];
+	Arena arena = { storage, storage + sizeof(storage) };
+	regex *re;
+
+	TEST(regex_compile(&arena, STR("(GET|POST) /[a-z0-9_]+\\?id=\\d+"), &re) == STATUS_OK);
+	TEST( regex_match(re, STR("GET /user_list?id=42")));
+	TEST( regex_match(re, STR("POST /x?id=0")));
+	TEST(!regex_match(re, STR("PUT /x?id=0")));
+	TEST(!regex_match(re, STR("GET /x?id=")));
+	TEST(!regex_match(re, STR("GET /x?id=1 ")));
+
+	TEST(regex_compile(&arena, STR("a(b|c)*d?"), &re) == STATUS_OK);
+	TEST( regex_match(re, STR("a")));
+	TEST( regex_match(re, STR("abcbcd")));
+	TEST(!regex_match(re, STR("abdd")));
+	TEST(!regex_match(re, STR("")));
+
+	TEST(regex_compile(&arena, STR("[^\\s]+\\.\\w+"), &re) == STATUS_OK);
+	TEST( regex_match(re, STR("krclib.c")));
+	TEST(!regex_match(re, STR("kr clib.c")));
+
+	TEST(regex_compile(&arena, STR("."), &re) == STATUS_OK);
+	TEST( regex_match(re, STR("\xFF")));
+	TEST(!regex_match(re, STR("\n")));
+}
+
+TEST_CASE(search_and_find_with_regex)
+{
+	static Byte storage[1 << 18];
+	Arena arena = { storage, storage + sizeof(storage) };
+	regex *re;
+
+	TEST(regex_compile(&arena, STR("err(or)?: \\d+"), &re) == STATUS_OK);
+	TEST( regex_search(re, STR("12:00 error: 404 not found")));
+	TEST(!regex_search(re, STR("12:00 error 404 not found")));
+	TEST( regex_finds(re, STR("12:00 err: 5, error: 404"), "err: 5"));
+	TEST( regex_finds(re, STR("no failure here"), NULL));
+
+	// Leftmost wins over shortest, then longest from there.
+	TEST(regex_compile(&arena, STR("abcd|c|bcdef"), &re) == STATUS_OK);
+	TEST( regex_finds(re, STR("xabcdefg"), "abcd"));
+	TEST(regex_compile(&arena, STR("a+"), &re) == STATUS_OK);
+	TEST( regex_finds(re, STR("baaab"), "aaa"));
+
+	TEST(regex_compile(&arena, STR("^\\d+"), &re) == STATUS_OK);
+	TEST( regex_finds(re, STR("123abc"), "123"));
+	TEST( regex_finds(re, STR("abc123"), NULL));
+	TEST(!regex_search(re, STR("abc123")));
+
+	TEST(regex_compile(&arena, STR("\\d+$"), &re) == STATUS_OK);
+	TEST( regex_finds(re, STR("12abc345"), "345"));
+	TEST(!regex_search(re, STR("12abc")));
+
+	TEST(regex_compile(&arena, STR("x*"), &re) == STATUS_OK);
+	TEST( regex_search(re, STR("abc")));
+	TEST( regex_finds(re, STR("abc"), ""));
+}
+
+TEST_CASE(regex_survives_dfa_cache_flush)
+{
+	static Byte storage[1 << 18];
+	Arena arena = { storage, storage + sizeof(storage) };
+	regex *re;
+
+	// Tracking which of the last eight bytes were 'a' takes 256 states.
+	TEST(regex_compile(&arena, STR("a[ab][ab][ab][ab][ab][ab][ab]"), &re) == STATUS_OK);
+
+	char text[2000];
+	uint64_t seed = 7;
+	for (int i = 0; i < (int)sizeof(text); ++i) {
+		seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+		text[i] = "ab"[(seed >> 33) & 1];
+	}
+
+	bool all_agree = true;
+	for (int n = 0; n <= (int)sizeof(text); n += 37) {
+		struct strand t = strand_init_n(text, n), found;
+		const char *a = memchr(text, 'a', n);
+		bool expect = a && a + 8 <= text + n;
+
+		all_agree &= (regex_search(re, t) == expect);
+		all_agree &= (regex_find(re, t, &found) == expect);
+		if (expect)
+			all_agree &= (found.front == a && strand_length(found) == 8);
+	}
+	TEST(all_agree);
+}
+
+TEST_CASE(match_globs)
+{
+	static Byte storage[1 << 18];
+	Arena arena = { storage, storage + sizeof(storage) };
+	regex *re;
+
+	TEST(glob_compile(&arena, STR("*.[ch]"), &re) == STATUS_OK);
+	TEST( regex_match(re, STR("krclib.c")));
+	TEST( regex_match(re, STR("src/krclib.h")));
+	TEST( regex_match(re, STR(".c")));
+	TEST(!regex_match(re, STR("krclib.o")));
+	TEST(!regex_match(re, STR("krclib.cc")));
+
+	TEST(glob_compile(&arena, STR("test_?[!0-9]*\\*"), &re) == STATUS_OK);
+	TEST( regex_match(re, STR("test_kr.c*")));
+	TEST(!regex_match(re, STR("test_k1.c*")));
+	TEST(!regex_match(re, STR("test_kr.c")));
+
+	TEST(glob_compile(&arena, STR("[abc"), &re) == STATUS_ERROR);
+}
+
+//-----------------------------------------------------------------------------
+// diff
+//
+
+static int dp_levenshtein(const char *x, int m, const char *y, int n)
+{
+	int row[300];
+	for (int j = 0; j <= n; ++j)
+		row[j] = j;
+	for (int i = 1; i <= m; ++i) {
+		int diag = row[0];
+		row[0] = i;
+		for (int j = 1; j <= n; ++j) {
+			int up = row[j];
+			row[j] = int_min(int_min(row[j] + 1, row[j-1] + 1), diag + (x[i-1] != y[j-1]));
+			diag = up;
+		}
+	}
+	return row[n];
+}
+
+TEST_CASE(levenshtein_distance)
+{
+	static Byte storage[1 << 16];
+	Arena arena = { storage, storage + sizeof(storage) };
+
+	TEST(levenshtein(&arena, STR("kitten"), STR("sitting")) == 3);
+	TEST(levenshtein(&arena, STR("flaw"), STR("lawn")) == 2);
+	TEST(levenshtein(&arena, STR(""), STR("abc")) == 3);
+	TEST(levenshtein(&arena, STR("abc"), STR("")) == 3);
+	TEST(levenshtein(&arena, STR("same"), STR("same")) == 0);
+	TEST(levenshtein_String(&arena, Str("Saturday"), Str("Sunday")) == 3);
+
+	// Scratch space is given back.
+	TEST(arena.beg == storage);
+}
+
+TEST_CASE(levenshtein_agrees_with_dynamic_programming)
+{
+	static Byte storage[1 << 16];
+	Arena arena = { storage, storage + sizeof(storage) };
+	char x[300], y[300];
+	uint64_t seed = 99;
+	bool all_agree = true;
+
+	// Lengths cross one, two and several 64-char blocks.
+	for (int trial = 0; trial < 40; ++trial) {
+		int m = trial * 7 % 290, n = (trial * 13 + 5) % 290;
+		for (int i = 0; i < 300; ++i) {
+			seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+			x[i] = "acgt"[(seed >> 33) & 3];
+			y[i] = "acgt"[(seed >> 40) & 3];
+		}
+		for (int i = 0; i < n; i += 5)
+			y[i] = x[i];
+
+		Size d = levenshtein(&arena, strand_init_n(x, m), strand_init_n(y, n));
+		all_agree &= (d == dp_levenshtein(x, m, y, n));
+	}
+
+	TEST(all_agree);
+}
+
+static int dp_lcs(const struct strand a[], int n, const struct strand b[], int m)
+{
+	static int table[40][40];
+	for (int i = n; i >= 0; --i)
+		for (int j = m; j >= 0; --j)
+			table[i][j] = (i == n || j == m) ? 0
+				: strand_equals(a[i], b[j]) ? 1 + table[i+1][j+1]
+				: int_max(table[i+1][j], table[i][j+1]);
+	return table[0][0];
+}
+
+// Apply d to before and check that it gives after.
+static bool diff_rebuilds(diff d, const struct strand before[], int before_count, const struct strand after[], int after_count)
+{
+	int i = 0, j = 0;
+	for (int e = 0; e < d.count; ++e) {
+		diff_edit edit = d.edits[e];
+		if (edit.from != i || edit.to != j || edit.count <= 0)
+			return false;
+		for (int k = 0; k < edit.count; ++k) {
+			if (edit.op == DIFF_KEEP && !strand_equals(before[i], after[j]))
+				return false;
+			i += (edit.op != DIFF_INSERT);
+			j += (edit.op != DIFF_DELETE);
+		}
+	}
+	return i == before_count && j == after_count;
+}
+
+TEST_CASE(diff_lines_of_text)
+{
+	static Byte storage[1 << 16];
+	Arena arena = { storage, storage + sizeof(storage) };
+	struct strand before[] = { STR("a"), STR("b"), STR("c"), STR("a"), STR("b"), STR("b"), STR("a") };
+	struct strand after[] = { STR("c"), STR("b"), STR("a"), STR("b"), STR("a"), STR("c") };
+
+	diff d = diff_lines(&arena, before, ARRAY_SIZE(before), after, ARRAY_SIZE(after));
+	TEST(d.distance == 5);
+	TEST(diff_rebuilds(d, before, ARRAY_SIZE(before), after, ARRAY_SIZE(after)));
+
+	diff same = diff_lines(&arena, before, ARRAY_SIZE(before), before, ARRAY_SIZE(before));
+	TEST(same.count == 1 && same.edits[0].op == DIFF_KEEP && same.distance == 0);
+
+	diff added = diff_lines(&arena, NULL, 0, after, ARRAY_SIZE(after));
+	TEST(added.count == 1 && added.edits[0].op == DIFF_INSERT && added.distance == 6);
+
+	TEST(diff_lines(&arena, NULL, 0, NULL, 0).count == 0);
+}
+
+TEST_CASE(diff_is_shortest_edit_script)
+{
+	static Byte storage[1 << 16];
+	struct strand words[] = { STR("int"), STR("x"), STR("="), STR("0"), STR(";") };
+	struct strand before[36], after[36];
+	uint64_t seed = 5;
+	bool all_agree = true;
+
+	for (int trial = 0; trial < 50; ++trial) {
+		Arena arena = { storage, storage + sizeof(storage) };
+		int n = trial % 36, m = (trial * 7) % 36;
+		for (int i = 0; i < 36; ++i) {
+			seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+			before[i] = words[(seed >> 33) % 5];
+			after[i] = words[(seed >> 45) % 5];
+		}
+
+		diff d = diff_lines(&arena, before, n, after, m);
+		all_agree &= diff_rebuilds(d, before, n, after, m);
+		all_agree &= (d.distance == n + m - 2 * dp_lcs(before, n, after, m));
+	}
+
+	TEST(all_agree);
+}
+
 //-----------------------------------------------------------------------------
 // Doubly linked List
 //
@@ -896,6 +1938,781 @@ TEST_CASE(add_item_to_empty_list)
 
 
 
+_Static_assert(sizeof(ListDims) == 2 * sizeof(Size), "list dims are Size, not int");
+
+TEST_CASE(list_growth_policy)
+{
+	LIST(int) *l = NULL;
+
+	List_set_growth(150);
+	LIST_RESERVE(l, 10);
+	TEST(List_capacity(l) == 10);
+	LIST_ADD(l, 11);
+	TEST(List_capacity(l) == 15);
+
+	List_set_growth(100);
+	LIST_ADD(l, 5);
+	TEST(List_length(l) == 16);
+	TEST(List_capacity(l) == 16);
+
+	List_set_growth(200);
+	LIST_PUSH(l, 7);
+	TEST(List_capacity(l) == 32);
+	TEST(LIST_LAST(l) == 7);
+
+	List_dispose(l);
+}
+
+TEST_CASE(shrink_list_to_fit)
+{
+	LIST(int) *l = NULL;
+	for (int i = 0; i < 100; ++i)
+		LIST_PUSH(l, i);
+	TEST(List_capacity(l) > 100);
+
+	LIST_SHRINK_TO_FIT(l);
+	TEST(List_capacity(l) == 100);
+	TEST(List_length(l) == 100);
+	TEST(LIST_AT(l, 0) == 0 && LIST_LAST(l) == 99);
+
+	l->head.length = 0;
+	LIST_SHRINK_TO_FIT(l);
+	TEST(l == NULL);
+}
+
+TEST_CASE(append_span_to_list)
+{
+	LIST(int) *l = NULL;
+	int million = 1000000;
+	int *data = malloc(million * sizeof(int));
+	for (int i = 0; i < million; ++i)
+		data[i] = i;
+
+	LIST_APPEND_N(l, data, million);
+	TEST(List_length(l) == million);
+	TEST(List_capacity(l) == million);
+	TEST(LIST_AT(l, 123456) == 123456);
+
+	int more[] = { -1, -2, -3 };
+	LIST_APPEND_SPAN(l, int_span_init_n(more, ARRAY_SIZE(more)));
+	TEST(List_length(l) == million + 3);
+	TEST(LIST_LAST(l) == -3);
+
+	struct int_span view = LIST_SPAN(l, int_span);
+	TEST(view.back - view.front == million + 3);
+	TEST(view.front[million] == -1);
+
+	free(data);
+	List_dispose(l);
+}
+
+TEST_CASE(insert_and_erase_list_ranges)
+{
+	LIST(int) *l = NULL;
+	int digits[] = { 0, 1, 2, 7, 8, 9 };
+	int middle[] = { 3, 4, 5, 6 };
+
+	LIST_APPEND_N(l, digits, ARRAY_SIZE(digits));
+	LIST_INSERT_N(l, 3, middle, ARRAY_SIZE(middle));
+	TEST(List_length(l) == 10);
+	for (int i = 0; i < 10; ++i)
+		TEST(LIST_AT(l, i) == i);
+
+	LIST_INSERT_N(l, 0, middle, 1);
+	TEST(LIST_AT(l, 0) == 3 && LIST_AT(l, 1) == 0);
+
+	LIST_ERASE(l, 0, 1);
+	LIST_ERASE(l, 2, 5);
+	TEST(List_length(l) == 5);
+	TEST(LIST_AT(l, 1) == 1 && LIST_AT(l, 2) == 7);
+
+	LIST_SWAP_REMOVE(l, 0);
+	TEST(List_length(l) == 4);
+	TEST(LIST_AT(l, 0) == 9 && LIST_LAST(l) == 8);
+
+	LIST_SWAP_REMOVE(l, 3);
+	TEST(List_length(l) == 3 && LIST_LAST(l) == 7);
+
+	List_dispose(l);
+}
+
+TEST_CASE(insert_list_into_itself)
+{
+	LIST(int) *l = NULL;
+	int digits[] = { 0, 1, 2, 3 };
+	LIST_APPEND_N(l, digits, ARRAY_SIZE(digits));
+
+	// Full lists have to move to grow, taking the source with them.
+	LIST_SHRINK_TO_FIT(l);
+	LIST_APPEND_SPAN(l, LIST_SPAN(l, int_span));
+	int doubled[] = { 0, 1, 2, 3, 0, 1, 2, 3 };
+	TEST(List_length(l) == 8 && !memcmp(l->front, doubled, sizeof(doubled)));
+
+	// A source straddling the insertion point is split by the shift.
+	LIST_TRUNCATE(l, 4);
+	LIST_SHRINK_TO_FIT(l);
+	LIST_INSERT_N(l, 2, &l->front[1], 2);
+	int straddled[] = { 0, 1, 1, 2, 2, 3 };
+	TEST(List_length(l) == 6 && !memcmp(l->front, straddled, sizeof(straddled)));
+
+	LIST_INSERT_N(l, 0, &l->front[4], 2);
+	int behind[] = { 2, 3, 0, 1, 1, 2, 2, 3 };
+	TEST(List_length(l) == 8 && !memcmp(l->front, behind, sizeof(behind)));
+
+	List_dispose(l);
+}
+
+TEST_CASE(resize_and_truncate_list)
+{
+	LIST(int) *l = NULL;
+
+	LIST_RESIZE(l, 4);
+	TEST(List_length(l) == 4);
+	TEST(LIST_AT(l, 0) == 0 && LIST_LAST(l) == 0);
+
+	LIST_AT(l, 3) = 33;
+	LIST_TRUNCATE(l, 2);
+	TEST(List_length(l) == 2);
+	LIST_TRUNCATE(l, 10);
+	TEST(List_length(l) == 2);
+
+	LIST_RESIZE(l, 4);
+	TEST(LIST_AT(l, 3) == 0);
+
+	LIST_RESIZE_UNINIT(l, 6);
+	TEST(List_length(l) == 6);
+
+	struct int_span empty = LIST_SPAN((LIST(int)*)NULL, int_span);
+	TEST(int_span_is_empty(empty));
+
+	List_dispose(l);
+}
+
+TEST_CASE(small_list_stays_inline)
+{
+	SMALL_LIST(int, 8) s = {0};
+	TEST(List_length(&s) == 0);
+	TEST(SMALL_LIST_IS_LOCAL(&s));
+
+	for (int i = 0; i < 8; ++i)
+		SMALL_LIST_PUSH(&s, i * i);
+
+	TEST(SMALL_LIST_IS_LOCAL(&s));
+	TEST(List_length(&s) == 8);
+	TEST(List_capacity(&s) == 8);
+	TEST(SMALL_LIST_FRONT(&s) == s.local);
+	TEST(SMALL_LIST_AT(&s, 3) == 9);
+	TEST(SMALL_LIST_LAST(&s) == 49);
+
+	SMALL_LIST_DISPOSE(&s);
+	TEST(List_is_empty(&s));
+}
+
+TEST_CASE(small_list_spills_to_heap)
+{
+	SMALL_LIST(int, 4) s = {0};
+	int values[] = { 1, 2, 3 };
+
+	SMALL_LIST_APPEND_N(&s, values, 3);
+	TEST(SMALL_LIST_IS_LOCAL(&s));
+
+	SMALL_LIST_PUSH(&s, 4);
+	SMALL_LIST_PUSH(&s, 5);
+	TEST(!SMALL_LIST_IS_LOCAL(&s));
+	TEST(List_length(&s) == 5);
+	TEST(List_capacity(&s) >= 5);
+	for (int i = 0; i < 5; ++i)
+		TEST(SMALL_LIST_AT(&s, i) == i + 1);
+
+	SMALL_LIST_RESERVE(&s, 100);
+	TEST(List_capacity(&s) == 100);
+	TEST(SMALL_LIST_LAST(&s) == 5);
+
+	SMALL_LIST_DISPOSE(&s);
+	TEST(SMALL_LIST_IS_LOCAL(&s));
+	TEST(List_length(&s) == 0);
+}
+
+TEST_CASE(small_list_appends_itself)
+{
+	SMALL_LIST(int, 8) s = {0};
+	int values[] = { 1, 2, 3, 4 };
+	SMALL_LIST_APPEND_N(&s, values, 4);
+
+	// Fits locally, then spills while copying from local storage.
+	SMALL_LIST_APPEND_N(&s, SMALL_LIST_FRONT(&s), 4);
+	TEST(SMALL_LIST_IS_LOCAL(&s) && List_length(&s) == 8);
+	SMALL_LIST_APPEND_N(&s, SMALL_LIST_FRONT(&s), 8);
+	TEST(!SMALL_LIST_IS_LOCAL(&s) && List_length(&s) == 16);
+
+	// Grows on the heap by realloc.
+	while (List_length(&s) < List_capacity(&s))
+		SMALL_LIST_PUSH(&s, 0);
+	Size length = List_length(&s);
+	SMALL_LIST_APPEND_N(&s, SMALL_LIST_FRONT(&s), length);
+	TEST(List_length(&s) == 2 * length);
+
+	bool copied = true;
+	for (int i = 0; i < 16; ++i)
+		copied = copied && SMALL_LIST_AT(&s, i) == values[i % 4];
+	for (Size i = 0; i < length; ++i)
+		copied = copied && SMALL_LIST_AT(&s, length + i) == SMALL_LIST_AT(&s, i);
+	TEST(copied);
+
+	SMALL_LIST_DISPOSE(&s);
+}
+
+LIST_TEMPLATE(double, dub_list)
+
+TEST_CASE(typed_list_push_and_pop)
+{
+	struct dub_list *l = NULL;
+	TEST(dub_list_length(l) == 0);
+	TEST(dub_list_capacity(l) == 0);
+
+	for (int i = 0; i < 100; ++i)
+		l = dub_list_push(l, i * 0.5);
+
+	TEST(dub_list_length(l) == 100);
+	TEST(*dub_list_at(l, 10) == 5.0);
+	TEST(*dub_list_last(l) == 49.5);
+
+	*dub_list_at(l, 0) = -1.0;
+	TEST(LIST_AT(l, 0) == -1.0);
+
+	TEST(dub_list_pop(l) == 49.5);
+	TEST(dub_list_length(l) == 99);
+
+	// Typed lists work with the LIST macros too.
+	double more[] = { 7.0, 8.0 };
+	LIST_APPEND_N(l, more, ARRAY_SIZE(more));
+	TEST(dub_list_pop(l) == 8.0);
+
+	l = dub_list_reserve(l, 1000);
+	TEST(dub_list_capacity(l) == 1000);
+	TEST(dub_list_length(l) == 100);
+
+	dub_list_dispose(l);
+}
+
+struct entity {
+	double x, y;
+	char   name[8];
+};
+
+TEST_CASE(slot_map_insert_get_erase)
+{
+	slot_map m = SLOT_MAP_INIT(struct entity);
+
+	slot_handle jack  = slot_map_insert(&m, &(struct entity){ 1, 2, "Jack" });
+	slot_handle sandy = slot_map_insert(&m, &(struct entity){ 3, 4, "Sandy" });
+	slot_handle mike  = slot_map_insert(&m, &(struct entity){ 5, 6, "Mike" });
+	TEST(slot_map_count(&m) == 3);
+
+	struct entity *e = slot_map_get(&m, sandy);
+	TEST(e && !strcmp(e->name, "Sandy") && e->x == 3);
+
+	TEST(slot_map_erase(&m, jack));
+	TEST(!slot_map_erase(&m, jack));
+	TEST(!slot_map_contains(&m, jack));
+	TEST(slot_map_get(&m, jack) == NULL);
+	TEST(slot_map_count(&m) == 2);
+
+	// Moved elements keep their handles.
+	TEST(!strcmp(((struct entity*)slot_map_get(&m, mike))->name, "Mike"));
+	TEST(!strcmp(((struct entity*)slot_map_get(&m, sandy))->name, "Sandy"));
+
+	// A reused slot gets a new generation, so the old handle stays stale.
+	slot_handle anne = slot_map_insert(&m, &(struct entity){ 7, 8, "Anne" });
+	TEST(anne.index == jack.index);
+	TEST(anne.generation != jack.generation);
+	TEST(slot_map_get(&m, jack) == NULL);
+	TEST(!strcmp(((struct entity*)slot_map_get(&m, anne))->name, "Anne"));
+
+	TEST(slot_map_get(&m, (slot_handle){0}) == NULL);
+	TEST(slot_map_get(&m, (slot_handle){ .index = 99, .generation = 1 }) == NULL);
+
+	slot_map_dispose(&m);
+	TEST(slot_map_count(&m) == 0);
+	TEST(slot_map_get(&m, sandy) == NULL);
+}
+
+TEST_CASE(iterate_live_slot_map_elements)
+{
+	slot_map m = SLOT_MAP_INIT(int);
+	slot_handle handles[100];
+
+	for (int i = 0; i < 100; ++i)
+		handles[i] = slot_map_insert(&m, &i);
+	for (int i = 0; i < 100; i += 3)
+		slot_map_erase(&m, handles[i]);
+
+	int sum = 0, expect = 0;
+	for (int i = 0; i < 100; ++i)
+		expect += (i % 3) ? i : 0;
+
+	bool handles_agree = true;
+	for (Size i = 0; i < slot_map_count(&m); ++i) {
+		int *value = slot_map_at(&m, i);
+		sum += *value;
+		handles_agree &= (slot_map_get(&m, slot_map_handle_at(&m, i)) == value);
+	}
+	TEST(slot_map_count(&m) == 66);
+	TEST(sum == expect);
+	TEST(handles_agree);
+
+	slot_map_clear(&m);
+	TEST(slot_map_count(&m) == 0);
+	TEST(!slot_map_contains(&m, handles[1]));
+
+	slot_map_dispose(&m);
+}
+
+DEQUE_TEMPLATE(int, int_deque)
+RING_TEMPLATE(int, int_ring, 8)
+
+TEST_CASE(deque_push_and_pop_at_both_ends)
+{
+	struct int_deque d = {0};
+	TEST(int_deque_is_empty(&d));
+
+	for (int i = 0; i < 10; ++i) {
+		int_deque_push_back(&d, i);
+		int_deque_push_front(&d, -i);
+	}
+	TEST(int_deque_length(&d) == 20);
+	TEST(*int_deque_at(&d, 0) == -9);
+	TEST(*int_deque_at(&d, -1) == 9);
+	TEST(*int_deque_at(&d, 10) == 0);
+
+	TEST(int_deque_pop_front(&d) == -9);
+	TEST(int_deque_pop_back(&d) == 9);
+	TEST(int_deque_length(&d) == 18);
+
+	int_deque_clear(&d);
+	TEST(int_deque_is_empty(&d));
+
+	int_deque_dispose(&d);
+	TEST(d.cap == 0 && d.items == NULL);
+}
+
+TEST_CASE(deque_wraps_and_grows)
+{
+	struct int_deque d = {0};
+	int_deque_reserve(&d, 8);
+	TEST(d.cap == 8);
+
+	// Walk the contents around the end of the buffer.
+	for (int i = 0; i < 6; ++i)
+		int_deque_push_back(&d, i);
+	for (int i = 0; i < 5; ++i)
+		TEST(int_deque_pop_front(&d) == i);
+	for (int i = 6; i < 12; ++i)
+		int_deque_push_back(&d, i);
+	TEST(d.cap == 8);
+	TEST(d.head + int_deque_length(&d) > d.cap);
+
+	// Growing unwraps the contents.
+	int more[] = { 12, 13, 14, 15, 16 };
+	int_deque_write(&d, more, ARRAY_SIZE(more));
+	TEST(d.cap == 16);
+	TEST(int_deque_length(&d) == 12);
+
+	int out[20];
+	TEST(int_deque_read(&d, out, 20) == 12);
+	for (int i = 0; i < 12; ++i)
+		TEST(out[i] == 5 + i);
+
+	int_deque_dispose(&d);
+}
+
+TEST_CASE(fixed_ring_reports_full)
+{
+	struct int_ring r = {0};
+	int value;
+
+	for (int i = 0; i < 8; ++i)
+		TEST(int_ring_push(&r, i));
+	TEST(int_ring_is_full(&r));
+	TEST(!int_ring_push(&r, 8));
+
+	TEST(int_ring_pop(&r, &value) && value == 0);
+	TEST(int_ring_pop(&r, &value) && value == 1);
+
+	int in[] = { 8, 9, 10, 11 };
+	TEST(int_ring_write(&r, in, ARRAY_SIZE(in)) == 2);
+	TEST(*int_ring_at(&r, -1) == 9);
+
+	int out[8];
+	TEST(int_ring_read(&r, out, 8) == 8);
+	TEST(out[0] == 2 && out[7] == 9);
+	TEST(!int_ring_pop(&r, &value));
+}
+
+SPSC_QUEUE_TEMPLATE(int, int_spsc)
+MPMC_QUEUE_TEMPLATE(int, int_mpmc)
+
+TEST_CASE(spsc_queue_try_api)
+{
+	struct int_spsc q;
+	TEST(int_spsc_init(&q, 6) == STATUS_OK);
+	TEST(q.mask == 7);
+
+	int value;
+	TEST(!int_spsc_try_pop(&q, &value));
+	for (int i = 0; i < 8; ++i)
+		TEST(int_spsc_try_push(&q, i));
+	TEST(!int_spsc_try_push(&q, 8));
+
+	TEST(int_spsc_try_pop(&q, &value) && value == 0);
+	TEST(int_spsc_try_push(&q, 8));
+
+	int out[16];
+	TEST(int_spsc_pop_n(&q, out, 16) == 8);
+	TEST(out[0] == 1 && out[7] == 8);
+
+	// Batches wrap around the end of the ring.
+	int in[] = { 10, 11, 12, 13, 14, 15, 16, 17, 18 };
+	TEST(int_spsc_push_n(&q, in, ARRAY_SIZE(in)) == 8);
+	TEST(int_spsc_pop_n(&q, out, 3) == 3);
+	TEST(int_spsc_pop_n(&q, out, 16) == 5);
+	TEST(out[0] == 13 && out[4] == 17);
+
+	int_spsc_dispose(&q);
+}
+
+TEST_CASE(mpmc_queue_try_api)
+{
+	struct int_mpmc q;
+	TEST(int_mpmc_init(&q, 4) == STATUS_OK);
+
+	int value;
+	TEST(!int_mpmc_try_pop(&q, &value));
+	for (int i = 0; i < 4; ++i)
+		TEST(int_mpmc_try_push(&q, i));
+	TEST(!int_mpmc_try_push(&q, 4));
+
+	TEST(int_mpmc_try_pop(&q, &value) && value == 0);
+	TEST(int_mpmc_try_pop(&q, &value) && value == 1);
+
+	int in[] = { 4, 5, 6 };
+	TEST(int_mpmc_push_n(&q, in, ARRAY_SIZE(in)) == 2);
+
+	int out[8];
+	TEST(int_mpmc_pop_n(&q, out, 8) == 4);
+	TEST(out[0] == 2 && out[1] == 3 && out[2] == 4 && out[3] == 5);
+	TEST(int_mpmc_pop_n(&q, out, 8) == 0);
+	TEST(int_mpmc_push_n(&q, in, 0) == 0);
+
+	int_mpmc_dispose(&q);
+}
+
+#define INT_LESS(A_, B_)  ((A_) < (B_))
+HEAP_TEMPLATE(int, int_heap, INT_LESS)
+
+TEST_CASE(heap_orders_pushes_and_heapify)
+{
+	struct int_heap h = {0};
+	TEST(int_heap_is_empty(&h));
+
+	uint32_t x = 0x2545F491;
+	for (int i = 0; i < 200; ++i) {
+		XORSHIFT_TEMPLATE(x, 13, 17, 5);
+		int_heap_push(&h, x % 1000);
+	}
+	TEST(int_heap_length(&h) == 200);
+
+	int previous = -1;
+	bool sorted = true;
+	while (!int_heap_is_empty(&h)) {
+		int next = int_heap_pop(&h);
+		sorted = sorted && previous <= next;
+		previous = next;
+	}
+	TEST(sorted);
+
+	int items[] = { 9, 3, 7, 1, 8, 2, 6, 5, 4, 0 };
+	int_heap_heapify(&h, items, ARRAY_SIZE(items));
+	int_heap_push(&h, -1);
+	for (int i = -1; i < 10; ++i)
+		TEST(int_heap_pop(&h) == i);
+
+	int_heap_heapify(&h, items, 1);
+	TEST(*int_heap_top(&h) == 9);
+	int_heap_dispose(&h);
+}
+
+TEST_CASE(heap_decrease_key_runs_dijkstra)
+{
+	// Directed edges, from 0: the direct edges are never the shortest.
+	enum { NODES = 5 };
+	int weight[NODES][NODES] = {
+		{ 0, 10, 3, 0, 20 },
+		{ 0, 0, 0, 2, 0 },
+		{ 0, 4, 0, 8, 0 },
+		{ 0, 0, 0, 0, 1 },
+		{ 0, 0, 0, 0, 0 },
+	};
+	int dist[NODES] = { 0, INT_MAX, INT_MAX, INT_MAX, INT_MAX };
+
+	struct int_heap h = {0};
+	int_heap_push_id(&h, 0, 0);
+	while (!int_heap_is_empty(&h)) {
+		Size u = int_heap_top_id(&h);
+		int d = int_heap_pop(&h);
+		TEST(!int_heap_contains(&h, u));
+		for (int v = 0; v < NODES; ++v) {
+			if (weight[u][v] && d + weight[u][v] < dist[v]) {
+				dist[v] = d + weight[u][v];
+				int_heap_push_id(&h, v, dist[v]);
+			}
+		}
+	}
+	TEST(dist[1] == 7 && dist[2] == 3 && dist[3] == 9 && dist[4] == 10);
+
+	int_heap_push(&h, 50);
+	int_heap_push_id(&h, 3, 40);
+	int_heap_push_id(&h, 7, 30);
+	TEST(int_heap_contains(&h, 3) && !int_heap_contains(&h, 4));
+	int_heap_decrease(&h, 3, 10);
+	TEST(int_heap_top_id(&h) == 3 && *int_heap_top(&h) == 10);
+	TEST(int_heap_pop(&h) == 10 && int_heap_pop(&h) == 30);
+	TEST(int_heap_top_id(&h) == -1 && int_heap_pop(&h) == 50);
+
+	for (int id = 0; id < 8; ++id)
+		int_heap_push_id(&h, id, id * 10);
+	int_heap_push_id(&h, 0, 75);
+	int_heap_update(&h, 3, 5);
+	int_heap_update(&h, 1, 65);
+	int expect[] = { 5, 20, 40, 50, 60, 65, 70, 75 };
+	bool ordered = true;
+	for (int i = 0; i < ARRAY_SIZE(expect); ++i)
+		ordered = ordered && int_heap_pop(&h) == expect[i];
+	TEST(ordered);
+
+	int_heap_clear(&h);
+	TEST(!int_heap_contains(&h, 7));
+	int_heap_dispose(&h);
+}
+
+TEST_CASE(uint64_bit_counts)
+{
+	TEST(uint64_popcount(0) == 0 && uint64_popcount(~0ull) == 64);
+	TEST(uint64_leading_zeros(0) == 64 && uint64_trailing_zeros(0) == 64);
+	TEST(uint64_leading_zeros(1) == 63 && uint64_trailing_zeros(1ull << 63) == 63);
+
+	uint64_t x = 0x9E3779B97F4A7C15ull;
+	bool agree = true;
+	for (int i = 0; i < 1000; ++i) {
+		XORSHIFT_TEMPLATE(x, 13, 7, 17);
+		uint64_t w = x >> (i % 64);
+		int pop = 0, lz = 0, tz = 0;
+		for (int bit = 0; bit < 64; ++bit)
+			pop += (w >> bit) & 1;
+		while (lz < 64 && !(w & (1ull << (63 - lz))))  ++lz;
+		while (tz < 64 && !(w & (1ull << tz)))  ++tz;
+		agree = agree && uint64_popcount(w) == pop
+			&& uint64_leading_zeros(w) == lz && uint64_trailing_zeros(w) == tz;
+	}
+	TEST(agree);
+}
+
+TEST_CASE(bitset_set_test_and_scan)
+{
+	Byte mem[1 << 12];
+	Arena a = { mem, mem + sizeof(mem) };
+
+	struct bitset b = bitset_alloc(&a, 130);
+	TEST(bitset_is_empty(b) && bitset_count(b) == 0);
+	TEST(bitset_next_set(b, 0) == -1 && bitset_next_clear(b, 0) == 0);
+
+	bitset_set(&b, 0);
+	bitset_set(&b, 64);
+	bitset_set(&b, 129);
+	TEST(bitset_test(b, 64) && !bitset_test(b, 65));
+	TEST(bitset_count(b) == 3);
+	TEST(bitset_next_set(b, 0) == 0 && bitset_next_set(b, 1) == 64);
+	TEST(bitset_next_set(b, 65) == 129 && bitset_next_set(b, 130) == -1);
+
+	TEST(!bitset_test_and_set(&b, 5) && bitset_test_and_set(&b, 5));
+	bitset_clear(&b, 5);
+	bitset_clear(&b, 0);
+	TEST(bitset_next_clear(b, 0) == 0 && bitset_count(b) == 2);
+
+	bitset_fill(&b, true);
+	TEST(bitset_count(b) == 130 && bitset_next_clear(b, 0) == -1);
+	TEST(b.words[2] == 3);
+
+	struct bitset evens = bitset_alloc(&a, 130);
+	for (Size i = 0; i < 130; i += 2)
+		bitset_set(&evens, i);
+
+	bitset_andnot(&b, evens);
+	TEST(bitset_count(b) == 65 && bitset_next_set(b, 0) == 1);
+	bitset_xor(&b, evens);
+	TEST(bitset_count(b) == 130);
+	bitset_and(&b, evens);
+	TEST(bitset_equals(b, evens));
+	bitset_fill(&b, false);
+	bitset_or(&b, evens);
+	TEST(bitset_equals(b, evens));
+}
+
+TEST_CASE(bitset_heap_resize)
+{
+	struct bitset b = bitset_create(10);
+	bitset_fill(&b, true);
+	bitset_resize(&b, 3);
+	TEST(bitset_count(b) == 3);
+
+	bitset_resize(&b, 200);
+	TEST(bitset_count(b) == 3 && bitset_next_set(b, 3) == -1);
+	bitset_set(&b, 199);
+	TEST(bitset_next_set(b, 3) == 199);
+
+	bitset_resize(&b, 0);
+	TEST(b.words == NULL && bitset_count(b) == 0);
+	bitset_dispose(&b);
+}
+
+TEST_CASE(bitrank_rank_and_select)
+{
+	static Byte mem[1 << 16];
+	Arena a = { mem, mem + sizeof(mem) };
+
+	// Dense and sparse stretches so samples span many blocks.
+	struct bitset bits = bitset_alloc(&a, 20000);
+	uint32_t x = 0xC0FFEE;
+	for (Size i = 0; i < bits.length; ++i) {
+		XORSHIFT_TEMPLATE(x, 13, 17, 5);
+		if (x % ((i < 8000) ? 2 : 97) == 0)
+			bitset_set(&bits, i);
+	}
+	struct bitrank r = bitrank_build(&a, bits);
+	TEST(r.ones == bitset_count(bits));
+
+	bool ranks = true, selects = true;
+	Size ones = 0;
+	for (Size i = 0; i <= bits.length; ++i) {
+		ranks = ranks && bitrank_rank(&r, i) == ones && bitrank_rank0(&r, i) == i - ones;
+		if (i == bits.length)
+			break;
+		if (bitset_test(bits, i))
+			selects = selects && bitrank_select(&r, ones++) == i;
+		else
+			selects = selects && bitrank_select0(&r, i - ones) == i;
+	}
+	TEST(ranks);
+	TEST(selects);
+	TEST(bitrank_select(&r, r.ones) == -1 && bitrank_select0(&r, -1) == -1);
+
+	struct bitrank empty = bitrank_build(&a, bitset_alloc(&a, 0));
+	TEST(bitrank_rank(&empty, 0) == 0 && bitrank_select(&empty, 0) == -1);
+}
+
+// Select on counts that are exact multiples of the sample rate, with an
+// arena full of garbage so unwritten samples can't pass as zero.
+TEST_CASE(bitrank_select_at_sample_boundaries)
+{
+	static Byte mem[1 << 16];
+	memset(mem, 0xA5, sizeof(mem));
+	Arena a = { mem, mem + sizeof(mem) };
+
+	Size lengths[] = { 1024, 2048, 1536 };
+	Size strides[] = { 2, 2, 3 };   // 512 ones and zeros, 1024 of each, 512 ones
+	bool selects = true;
+	for (int t = 0; t < ARRAY_SIZE(lengths); ++t) {
+		struct bitset bits = bitset_alloc(&a, lengths[t]);
+		for (Size i = 0; i < bits.length; i += strides[t])
+			bitset_set(&bits, i);
+		struct bitrank r = bitrank_build(&a, bits);
+
+		Size ones = 0;
+		for (Size i = 0; i < bits.length; ++i) {
+			if (bitset_test(bits, i))
+				selects = selects && bitrank_select(&r, ones++) == i;
+			else
+				selects = selects && bitrank_select0(&r, i - ones) == i;
+		}
+		selects = selects && bitrank_select(&r, ones) == -1;
+	}
+	TEST(selects);
+
+	// Fewer than a sample's worth of ones, then of zeros, over several
+	// blocks, so the only sample is the first.
+	struct bitset sparse = bitset_alloc(&a, 1000);
+	bitset_set(&sparse, 3);
+	bitset_set(&sparse, 700);
+	struct bitrank rs = bitrank_build(&a, sparse);
+	TEST(bitrank_select(&rs, 0) == 3 && bitrank_select(&rs, 1) == 700);
+	TEST(bitrank_select0(&rs, 0) == 0 && bitrank_select0(&rs, 997) == 999);
+
+	bitset_fill(&sparse, true);
+	bitset_clear(&sparse, 10);
+	bitset_clear(&sparse, 900);
+	rs = bitrank_build(&a, sparse);
+	TEST(bitrank_select0(&rs, 0) == 10 && bitrank_select0(&rs, 1) == 900);
+	TEST(bitrank_select(&rs, 0) == 0 && bitrank_select(&rs, 997) == 999);
+
+	uint64_t few[300];
+	for (int i = 0; i < ARRAY_SIZE(few); ++i)
+		few[i] = i * 7;
+	struct elias_fano small = elias_fano_build(&a, few, ARRAY_SIZE(few));
+	bool small_gets = true;
+	for (int i = 0; i < ARRAY_SIZE(few); ++i)
+		small_gets = small_gets && elias_fano_get(&small, i) == few[i];
+	TEST(small_gets);
+
+	uint64_t values[512];
+	for (int i = 0; i < ARRAY_SIZE(values); ++i)
+		values[i] = i * 3;
+	struct elias_fano ef = elias_fano_build(&a, values, ARRAY_SIZE(values));
+	bool gets = true;
+	for (int i = 0; i < ARRAY_SIZE(values); ++i)
+		gets = gets && elias_fano_get(&ef, i) == values[i];
+	TEST(gets);
+}
+
+TEST_CASE(elias_fano_sorted_ids)
+{
+	static Byte mem[1 << 16];
+	Arena a = { mem, mem + sizeof(mem) };
+
+	enum { COUNT = 3000 };
+	uint64_t ids[COUNT], id = 5;
+	uint32_t x = 0xBADC0DE;
+	for (Size i = 0; i < COUNT; ++i) {
+		XORSHIFT_TEMPLATE(x, 13, 17, 5);
+		id += x % 1000;
+		ids[i] = id;
+	}
+
+	struct elias_fano ef = elias_fano_build(&a, ids, COUNT);
+	bool values = true;
+	for (Size i = 0; i < COUNT; ++i)
+		values = values && elias_fano_get(&ef, i) == ids[i];
+	TEST(values);
+	TEST(elias_fano_bits(&ef) < COUNT * 16);
+
+	TEST(elias_fano_lower_bound(&ef, 0) == 0);
+	TEST(elias_fano_lower_bound(&ef, ids[COUNT - 1] + 1) == COUNT);
+	bool bounds = true;
+	Size expect = 0;
+	for (uint64_t query = 0; query <= ids[COUNT - 1]; query += 7) {
+		while (ids[expect] < query)  ++expect;
+		bounds = bounds && elias_fano_lower_bound(&ef, query) == expect;
+	}
+	TEST(bounds);
+
+	uint64_t small[] = { 0, 0, 1, 2, 2, UINT64_C(1) << 40 };
+	struct elias_fano few = elias_fano_build(&a, small, ARRAY_SIZE(small));
+	TEST(elias_fano_get(&few, 1) == 0 && elias_fano_get(&few, 5) == small[5]);
+	TEST(elias_fano_lower_bound(&few, 2) == 3 && elias_fano_lower_bound(&few, 3) == 5);
+
+	struct elias_fano none = elias_fano_build(&a, NULL, 0);
+	TEST(elias_fano_lower_bound(&none, 7) == 0);
+}
+
 TEST_CASE(Xorshift_random_numbers)
 {
 	return;
@@ -54,6 +54,23 @@ TEST_CASE(create_formatted_string)
 	string *s = string_format("%s to %d/%d is %.5f", answer, 2, 3, 2.0/3.0);
 
 	TEST(string_equals(s, "the answer to 2/3 is 0.66667"));
+	TEST(string_length(s) == 28);
+
+	string_dispose(s);
+}
+
+TEST_CASE(format_string_longer_than_stack_buffer)
+{
+	char word[300];
+	memset(word, 'w', sizeof(word)-1);
+	word[sizeof(word)-1] = '\0';
+
+	string *s = string_format("<%s>", word);
+
+	TEST(string_length(s) == 301);
+	TEST(string_cstr(s)[0] == '<');
+	TEST(string_cstr(s)[300] == '>');
+	TEST(string_cstr(s)[301] == '\0');
 
 	string_dispose(s);
 }
@@ -77,3 +94,310 @@ TEST_CASE(grow_string_from_null)
 	string_dispose(s);
 }
 
+
+TEST_CASE(append_to_string)
+{
+	string *s = NULL;
+
+	s = string_append_strand(s, STR("Hello"));
+	TEST(string_equals(s, "Hello"));
+
+	s = string_append_String(s, Str(", world"));
+	s = string_append(s, ".!?", 1);
+	TEST(string_equals(s, "Hello, world."));
+	TEST(string_length(s) == 13);
+	TEST(string_size(s) > string_length(s));
+
+	string_dispose(s);
+}
+
+TEST_CASE(insert_and_replace_in_string)
+{
+	string *s = string_create("Hello world");
+
+	s = string_insert(s, 5, ",", 1);
+	TEST(string_equals(s, "Hello, world"));
+
+	s = string_insert(s, 0, ">> ", 3);
+	TEST(string_equals(s, ">> Hello, world"));
+
+	s = string_replace(s, 10, 5, "Pluto!", 6);
+	TEST(string_equals(s, ">> Hello, Pluto!"));
+
+	s = string_replace(s, 0, 3, "", 0);
+	TEST(string_equals(s, "Hello, Pluto!"));
+	TEST(string_length(s) == 13);
+
+	string_dispose(s);
+}
+
+TEST_CASE(replace_string_with_its_own_text)
+{
+	string *s = string_create("abcd");
+	while (!string_is_full(s))
+		s = string_pushc(s, '.');
+	s = string_replace(s, 4, string_length(s) - 4, "", 0);
+
+	// Growing moves the text the source points into.
+	s = string_append(s, string_cstr(s), string_length(s));
+	TEST(string_equals(s, "abcdabcd"));
+
+	// The source overlaps the part being replaced.
+	s = string_replace(s, 0, 4, string_cstr(s) + 2, 4);
+	TEST(string_equals(s, "cdababcd"));
+
+	s = string_insert(s, 8, NULL, 0);
+	TEST(string_length(s) == 8);
+	string_dispose(s);
+
+	string *empty = gapstring_to_string(NULL);
+	TEST(string_length(empty) == 0);
+	string_dispose(empty);
+}
+
+TEST_CASE(string_growth_policy)
+{
+	string *s = string_reserve(NULL, 16);
+
+	string_set_growth(STRING_GROW_EXACT);
+	s = string_reserve(s, 0);
+	TEST(string_size(s) == 17);
+
+	string_set_growth(STRING_GROW_HALF);
+	s = string_reserve(s, 0);
+	TEST(string_size(s) == 25);
+
+	string_set_growth(STRING_GROW_DOUBLE);
+	s = string_reserve(s, 0);
+	TEST(string_size(s) == 50);
+
+	// Bulk appends never grow less than what's needed.
+	char big[100] = "";
+	s = string_append(s, big, sizeof(big));
+	TEST(string_size(s) == 101);
+
+	string_dispose(s);
+}
+
+TEST_CASE(append_to_shared_string)
+{
+	string *a = string_create("abc");
+	string *b = string_share(a);
+
+	b = string_append(b, "def", 3);
+	TEST(string_equals(a, "abc"));
+	TEST(string_equals(b, "abcdef"));
+
+	string_dispose(a);
+	string_dispose(b);
+}
+
+TEST_CASE(shared_strings_copy_on_write)
+{
+	string *a = string_create("shared");
+	string *b = string_share(a);
+
+	TEST(a == b);
+	TEST(string_is_shared(a));
+
+	// Writing through b leaves a untouched.
+	b = string_pushc(b, '!');
+	TEST(a != b);
+	TEST(!string_is_shared(a));
+	TEST(!string_is_shared(b));
+	TEST(string_equals(a, "shared"));
+	TEST(string_length(b) == 7);
+	TEST(!strncmp(string_cstr(b), "shared!", 7));
+
+	string_dispose(a);
+	string_dispose(b);
+}
+
+TEST_CASE(dispose_shared_string_keeps_other_refs)
+{
+	string *a = string_create("xyzzy");
+	string *b = string_share(a);
+	string *c = string_share(a);
+
+	string_dispose(a);
+	TEST(string_is_shared(b));
+	string_dispose(b);
+	TEST(!string_is_shared(c));
+	TEST(string_equals(c, "xyzzy"));
+
+	c = string_clear(c);
+	TEST(string_is_empty(c));
+
+	string_dispose(c);
+}
+
+TEST_CASE(copy_string_is_independent)
+{
+	string *a = string_create("original");
+	string *b = string_copy(a);
+
+	TEST(a != b);
+	TEST(!string_is_shared(a));
+	TEST(string_equals(b, "original"));
+	TEST(string_copy(NULL) == NULL);
+
+	string_dispose(a);
+	string_dispose(b);
+}
+
+_Static_assert(sizeof(sstring) == SSTRING_LOCAL_SIZE, "sstring must fit in 24 bytes");
+
+TEST_CASE(zeroed_sstring_is_empty)
+{
+	sstring s = {0};
+
+	TEST(sstring_is_local(&s));
+	TEST(sstring_is_empty(&s));
+	TEST(sstring_length(&s) == 0);
+	TEST(sstring_equals(&s, ""));
+	TEST(!sstring_equals(&s, NULL));
+
+	sstring_dispose(&s);
+}
+
+TEST_CASE(short_sstring_stays_local)
+{
+	sstring s = sstring_create("key");
+
+	TEST(sstring_is_local(&s));
+	TEST(sstring_length(&s) == 3);
+	TEST(sstring_size(&s) == SSTRING_LOCAL_SIZE - 1);
+	TEST(sstring_equals(&s, "key"));
+
+	sstring longest = sstring_create("0123456789012345678901");
+	TEST(sstring_is_local(&longest));
+	TEST(sstring_length(&longest) == SSTRING_LOCAL_CAP);
+	TEST(sstring_is_full(&longest));
+
+	sstring_dispose(&s);
+	sstring_dispose(&longest);
+}
+
+TEST_CASE(long_sstring_moves_to_heap)
+{
+	char hello[] = "Hello, world. Goodbye, Pluto!";
+	sstring s = sstring_create(hello);
+
+	TEST(!sstring_is_local(&s));
+	TEST(sstring_length(&s) == strlen(hello));
+	TEST(sstring_equals(&s, hello));
+
+	sstring_dispose(&s);
+	TEST(sstring_is_local(&s));
+	TEST(sstring_is_empty(&s));
+}
+
+TEST_CASE(push_sstring_past_local_capacity)
+{
+	sstring s = {0};
+	char expect[40] = "";
+
+	for (int i = 0; i < 30; ++i) {
+		sstring_pushc(&s, 'a' + i % 26);
+		expect[i] = 'a' + i % 26;
+		TEST(sstring_is_local(&s) == (i < SSTRING_LOCAL_CAP));
+	}
+
+	TEST(sstring_length(&s) == 30);
+	TEST(sstring_equals(&s, expect));
+
+	sstring_clear(&s);
+	TEST(sstring_is_empty(&s));
+	TEST(sstring_equals(&s, ""));
+
+	sstring_dispose(&s);
+}
+
+static bool gapstring_equals(const gapstring *g, const char *cstr)
+{
+	string *s = gapstring_to_string(g);
+	bool same = string_equals(s, cstr);
+	string_dispose(s);
+	return same;
+}
+
+TEST_CASE(null_gapstring_is_empty)
+{
+	gapstring *g = NULL;
+
+	TEST(gapstring_length(g) == 0);
+	TEST(gapstring_cursor(g) == 0);
+	TEST(gapstring_size(g) == 0);
+	TEST(strand_is_empty(gapstring_strands(g).before));
+	TEST(strand_is_empty(gapstring_strands(g).after));
+	TEST(gapstring_equals(g, ""));
+
+	gapstring_dispose(g);
+}
+
+TEST_CASE(edit_gapstring_at_cursor)
+{
+	gapstring *g = gapstring_create("Hello world");
+	TEST(gapstring_cursor(g) == 11);
+
+	gapstring_move_to(g, 5);
+	g = gapstring_pushc(g, ',');
+	TEST(gapstring_equals(g, "Hello, world"));
+
+	gapstring_view view = gapstring_strands(g);
+	TEST(strand_equals(view.before, STR("Hello,")));
+	TEST(strand_equals(view.after, STR(" world")));
+
+	gapstring_move_by(g, 1);
+	gapstring_delete_after(g, 5);
+	g = gapstring_insert(g, "there", 5);
+	TEST(gapstring_equals(g, "Hello, there"));
+
+	gapstring_delete_before(g, 7);
+	TEST(gapstring_cursor(g) == 5);
+	TEST(gapstring_equals(g, "Hello"));
+
+	gapstring_move_to(g, 0);
+	g = gapstring_insert(g, "> ", 2);
+	gapstring_move_to(g, gapstring_length(g));
+	g = gapstring_pushc(g, '!');
+	TEST(gapstring_equals(g, "> Hello!"));
+
+	gapstring_dispose(g);
+}
+
+TEST_CASE(gapstring_keeps_text_after_cursor_when_growing)
+{
+	gapstring *g = gapstring_create("ab");
+	gapstring_move_to(g, 1);
+
+	char expect[300] = "a";
+	for (int i = 0; i < 256; ++i) {
+		g = gapstring_pushc(g, '0' + i % 10);
+		expect[1 + i] = '0' + i % 10;
+	}
+	strcat(expect, "b");
+
+	TEST(gapstring_cursor(g) == 257);
+	TEST(gapstring_length(g) == 258);
+	TEST(gapstring_size(g) >= 258);
+	TEST(gapstring_equals(g, expect));
+	TEST(strand_equals(gapstring_strands(g).after, STR("b")));
+
+	gapstring_dispose(g);
+}
+
+TEST_CASE(gapstring_create_empty)
+{
+	gapstring *g = gapstring_create("");
+	TEST(g != NULL);
+	TEST(gapstring_length(g) == 0);
+	TEST(gapstring_equals(g, ""));
+
+	g = gapstring_insert(g, "abc", 3);
+	gapstring_move_to(g, 1);
+	g = gapstring_insert(g, "", 0);
+	TEST(gapstring_equals(g, "abc"));
+
+	gapstring_dispose(g);
+}